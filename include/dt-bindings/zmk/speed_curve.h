@@ -0,0 +1,16 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+/*
+ * Gain cell for zmk,input-processor-speed-curve references: the computed
+ * movement is multiplied by num / den. A cell value of 0 means unity gain.
+ */
+#define ZIP_SPEED_CURVE_GAIN(num, den) ((((num) & 0xFFFF) << 16) | ((den) & 0xFFFF))
+
+#define ZIP_SPEED_CURVE_GAIN_NUM(gain) (((gain) >> 16) & 0xFFFF)
+#define ZIP_SPEED_CURVE_GAIN_DEN(gain) ((gain) & 0xFFFF)
@@ -7,6 +7,55 @@
 #pragma once
 
 #include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/sys/ring_buffer.h>
+
+#include <zmk/input_processors/speed_curve_engine.h>
+
+#define ZIP_SPEED_CURVE_BLOB_MAGIC 0x4243535A // "ZSCB"
+#define ZIP_SPEED_CURVE_BLOB_VERSION 1
+
+// Blob lut_shift flag: the LUT is log-spaced and the low bits hold its mantissa bits
+#define ZIP_SPEED_CURVE_BLOB_LUT_LOG 0x80
+
+/**
+ * @brief Header of a compiled curve blob (see scripts/speed_curve_blob.py)
+ *
+ * The header is followed by payload_len bytes of little-endian int32 words:
+ * num_points [time_ms, speed] pairs, num_points - 1 segment slopes and
+ * lut_len LUT entries, laid out like struct zip_speed_curve_profile expects.
+ * ZIP_SPEED_CURVE_BLOB_LUT_LOG in lut_shift marks a log-spaced LUT.
+ */
+struct zip_speed_curve_blob_header {
+    uint32_t magic;                 // ZIP_SPEED_CURVE_BLOB_MAGIC
+    uint16_t version;               // ZIP_SPEED_CURVE_BLOB_VERSION
+    uint8_t interpolation;          // enum zip_speed_curve_interpolation
+    uint8_t lut_shift;              // log2 of the LUT step in ms, or mantissa bits | LUT_LOG
+    uint16_t num_points;            // Number of curve points
+    uint16_t lut_len;               // Number of LUT entries
+    uint32_t payload_len;           // Size of the payload in bytes
+    uint32_t crc;                   // CRC-32 (IEEE) of the payload
+};
+
+/**
+ * @brief What the curve's x-axis is measured in (curve-input property)
+ */
+enum zip_speed_curve_input {
+    ZIP_SPEED_CURVE_INPUT_TIME,     // Elapsed uptime since movement started
+    ZIP_SPEED_CURVE_INPUT_FRAMES,   // Events since movement started * trigger period
+    ZIP_SPEED_CURVE_INPUT_VELOCITY, // Input speed in px/s (curve gives output px/s)
+    ZIP_SPEED_CURVE_INPUT_DISTANCE, // Distance emitted on this axis in px
+    ZIP_SPEED_CURVE_INPUT_DISTANCE_VECTOR, // Magnitude of the distance emitted on all axes in px
+};
+
+/**
+ * @brief Smoothing of the measured input speed (velocity-filter property)
+ */
+enum zip_speed_curve_filter {
+    ZIP_SPEED_CURVE_FILTER_NONE,
+    ZIP_SPEED_CURVE_FILTER_EMA,     // Low-pass at a fixed cutoff
+    ZIP_SPEED_CURVE_FILTER_ONE_EURO, // Low-pass with a cutoff that rises with speed changes
+};
 
 /**
  * @brief Configuration for speed curve input processor
@@ -15,25 +64,166 @@ struct zip_speed_curve_config {
     uint8_t type;                   // Input event type (e.g., INPUT_EV_REL)
     const uint16_t *codes;          // Array of event codes to process
     size_t codes_len;               // Number of codes
-    const int32_t *curve_points;    // Array of [time_ms, speed] pairs
-    size_t curve_points_len;        // Number of curve points (pairs)
+    const struct zip_speed_curve_profile *profiles; // Node curve first, then child nodes
+    size_t profiles_len;            // Number of profiles
     uint16_t trigger_period_ms;     // Period between events in ms
+    uint64_t movement_scale;        // px/event per px/s (32.32 fixed point, incl. scaler)
+    uint32_t output_gain;           // Scaler and output units (16.16 fixed point, velocity input)
     bool track_remainders;          // Whether to track sub-pixel remainders
+    bool suppress_zero_events;      // Drop events whose value ends up as 0
+    bool coalesce_reports;          // Release movement once per transport report interval
+    uint8_t curve_input;            // enum zip_speed_curve_input
+    uint16_t distance_reset_ms;     // Pause after which distance input starts over
+    uint16_t resume_window_ms;      // Re-press window that keeps momentum (0 = disabled)
+    uint8_t resume_retain_percent;  // Share of the elapsed time kept on resume
+    uint8_t reversal_frames;        // Opposite-sign events in a row that make a reversal
+    uint16_t reversal_threshold;    // Opposite magnitude that is a reversal at once (0 = off)
+    uint8_t velocity_filter;        // enum zip_speed_curve_filter
+    uint32_t filter_min_cutoff_mhz; // Filter cutoff at rest in mHz
+    uint32_t filter_d_cutoff_mhz;   // Cutoff for the speed's rate of change in mHz (one-euro)
+    uint32_t filter_beta;           // Cutoff increase in mHz per px/s^2 (one-euro)
+    uint16_t prediction_ms;         // How far ahead on the curve movement is emitted
+    const uint8_t *axis_groups;     // Group of each code (indexed like codes), or NULL
+    const uint8_t *group_next;      // Next code of the same group, a ring per group (axis-groups)
+    int32_t max_output;             // Largest value a single event may carry
+    const void *blob;               // Memory-mapped curve blob partition, or NULL
+    size_t blob_size;               // Size of the curve blob partition
 };
 
+// Wheel units per notch in hi-res-scroll mode (as for REL_WHEEL_HI_RES)
+#define ZIP_SPEED_CURVE_HI_RES_UNITS_PER_NOTCH 120
+
 // Timeout threshold: if no events for this many ms, consider movement stopped
 #define ZIP_SPEED_CURVE_TIMEOUT_MS 50
 
+/**
+ * @brief Runtime state for one axis (one entry per configured code)
+ */
+struct zip_speed_curve_axis {
+    int64_t start_time;             // Timestamp when movement started (uptime_get())
+    bool started;                   // start_time belongs to the current movement
+    int64_t last_event_time;        // Timestamp of last event (for timeout detection)
+    uint32_t last_event_cycles;     // Cycle count of last event (frames/velocity input)
+    uint32_t frames;                // Events since movement started (frames input)
+    int64_t distance;               // Distance emitted (distance input, FRAC_BITS fraction)
+    int64_t resume_until;           // Uptime until which the saved momentum can be resumed
+    uint32_t resume_elapsed;        // Elapsed ms to resume at
+    int8_t resume_direction;        // Direction the saved momentum applies to (0 = none)
+    uint8_t reversal_count;         // Opposite-sign events seen in a row
+    int32_t last_position;          // Last absolute position (INPUT_EV_ABS sources)
+    bool has_position;              // last_position belongs to the current touch
+    int32_t filtered_velocity;      // Smoothed input speed in px/s (velocity-filter)
+    int32_t filtered_accel;         // Smoothed rate of change of the speed in px/s^2 (one-euro)
+    bool filter_primed;             // The filter state belongs to the current movement
+    int32_t remainder;              // Sub-pixel remainder (ZIP_SPEED_CURVE_FRAC_BITS fraction)
+    int32_t pending;                // Whole px held back (coalescing, max-output, corrections)
+    int32_t trace_value;            // Last captured value of this code (trace value deltas)
+    int32_t group_value;            // Last value, as part of its group's vector (axis-groups)
+    uint32_t group_frame;           // Frame sequence number of group_value
+    int32_t lead;                   // Distance emitted ahead of the curve (FRAC_BITS fraction)
+    int8_t last_direction;          // Last direction: -1, 0, 1
+};
+
+// Trace record slot of INPUT_BTN_TOUCH events; other slots are code indices
+#define ZIP_SPEED_CURVE_TRACE_SLOT_TOUCH 0x7E
+
+// Trace byte that starts over from absolute time and values (after dropped records)
+#define ZIP_SPEED_CURVE_TRACE_RESTART 0xFF
+
+/**
+ * @brief Capture of incoming events (CONFIG_ZMK_INPUT_PROCESSOR_SPEED_CURVE_TRACE)
+ */
+struct zip_speed_curve_trace {
+    struct ring_buf buf;            // Encoded records, see scripts/speed_curve_trace.py
+    uint8_t *storage;               // Backing memory of buf
+    struct k_spinlock lock;         // Serializes capture and export
+    int64_t last_time;              // Uptime of the previous record
+    uint32_t dropped;               // Records lost to a full buffer since the last export
+    bool restart;                   // Start the next record over from absolute values
+};
+
+/**
+ * @brief Runtime state shared by the codes of an axis group (axis-groups property)
+ */
+struct zip_speed_curve_group {
+    int64_t start_time;             // Timestamp when the group started moving (time input)
+    uint32_t frames;                // Frames since the group started moving (frames input)
+    uint32_t frame;                 // Frame sequence number frames was last advanced in
+    bool started;                   // The clock belongs to the group's current movement
+    const struct zip_speed_curve_profile *profile; // Profile the cached speeds come from
+    uint32_t eval_frame;            // Frame sequence number of the cached speeds
+    int64_t position;               // Curve position of the cached speeds
+    int32_t speed;                  // Cached speed of the group's vector in px/s
+    int32_t predicted_speed;        // Cached speed prediction-ms further along the curve
+};
+
 /**
  * @brief Runtime data for speed curve input processor
  */
 struct zip_speed_curve_data {
-    int64_t x_start_time;           // Timestamp when X axis movement started (uptime_get())
-    int64_t y_start_time;           // Timestamp when Y axis movement started (uptime_get())
-    int64_t x_last_event_time;      // Timestamp of last X axis event (for timeout detection)
-    int64_t y_last_event_time;      // Timestamp of last Y axis event (for timeout detection)
-    int8_t last_x_direction;        // Last X direction: -1, 0, 1
-    int8_t last_y_direction;        // Last Y direction: -1, 0, 1
-    float x_remainder;              // Sub-pixel remainder for X axis
-    float y_remainder;              // Sub-pixel remainder for Y axis
+    struct zip_speed_curve_axis *axes;  // Per-axis state, indexed like codes
+    struct zip_speed_curve_group *groups; // Per-group state (axis-groups), or NULL
+    uint32_t frame_seq;             // Frames (synced events) seen so far
+    int64_t last_release_time;      // Timestamp of the last coalesced report
+    int64_t last_event_time;        // Timestamp of last event on any axis (distance-vector input)
+    int64_t distance;               // Distance emitted on all axes (distance-vector input)
+    uint64_t frame_distance_sq;     // Squared movement of the current frame (distance-vector input)
+    bool frame_pending;             // An event of the current frame was forwarded without sync
+    bool in_frame;                  // An event of the current frame was already seen
+    bool release_frame;             // The current frame releases coalesced movement
+    struct zip_speed_curve_profile blob_profile; // Validated curve blob replacing profile 0
+    bool profile_warned;            // A reference with a nonexistent profile was reported
+    struct zip_speed_curve_trace *trace; // Event capture, or NULL
+};
+
+/**
+ * @brief Reset the acceleration state of a speed curve processor
+ *
+ * Ends the current movement on all axes, as if each had timed out. Meant for
+ * frames input without CONFIG_ZMK_INPUT_PROCESSOR_SPEED_CURVE_FRAME_TIMEOUT,
+ * where the processor does not read any clock to notice that movement ended.
+ * Must be called from the thread that feeds events to the processor.
+ *
+ * @param dev Speed curve input processor device
+ * @return 0 on success
+ */
+int zip_speed_curve_reset(const struct device *dev);
+
+/**
+ * @brief Curve of a zmk,curve devicetree node
+ *
+ * Lets any module map a value through a devicetree curve with the same
+ * engine and flash tables as the speed curve processor.
+ */
+struct zip_curve {
+    struct zip_speed_curve_profile profile; // Curve points and interpolation
 };
+
+// Name of the curve generated for a zmk,curve node
+#define ZIP_CURVE_DT_NAME(node_id) _CONCAT(zip_curve_, DT_DEP_ORD(node_id))
+
+/**
+ * @brief Get the curve of an enabled zmk,curve node
+ *
+ * @param node_id Devicetree node identifier, e.g. DT_NODELABEL(brightness_ramp)
+ * @return Pointer to a const struct zip_curve
+ */
+#define ZIP_CURVE_DT_GET(node_id) (&ZIP_CURVE_DT_NAME(node_id))
+
+#define ZIP_CURVE_DT_DECLARE(node_id) extern const struct zip_curve ZIP_CURVE_DT_NAME(node_id);
+
+DT_FOREACH_STATUS_OKAY(zmk_curve, ZIP_CURVE_DT_DECLARE)
+
+/**
+ * @brief Evaluate a curve
+ *
+ * Positions before the first point give the first point's value, positions
+ * after the last point the last point's value.
+ *
+ * @param curve Curve from ZIP_CURVE_DT_GET()
+ * @param x Position on the curve, in the unit of the first value of each point
+ * @return Value of the curve at x
+ */
+static inline int32_t zip_curve_eval(const struct zip_curve *curve, int64_t x) {
+    return zip_speed_curve_eval(&curve->profile, x);
+}
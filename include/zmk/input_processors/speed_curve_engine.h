@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+/*
+ * Curve evaluation and fixed-point helpers of the speed curve processor.
+ *
+ * Only depends on the C standard library, so src/speed_curve_engine.c can be
+ * compiled on the host to compare engines or to evaluate curves offline.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Fraction bits of fixed-point movement and remainders
+#define ZIP_SPEED_CURVE_FRAC_BITS 16
+#define ZIP_SPEED_CURVE_FRAC_MASK ((1 << ZIP_SPEED_CURVE_FRAC_BITS) - 1)
+
+// Largest speed a curve point may give in px/s; keeps segment math within 64 bits
+#define ZIP_SPEED_CURVE_MAX_SPEED ((1 << 24) - 1)
+
+// Largest movement of a single frame (FRAC_BITS fraction), as much as any report holds
+#define ZIP_SPEED_CURVE_MAX_MOVEMENT ((int64_t)INT16_MAX << ZIP_SPEED_CURVE_FRAC_BITS)
+
+// num / den as a 32.32 or 16.16 fixed-point factor. Rounded up, so products that
+// should come out as whole pixels are not truncated to just below; a 32.32 factor
+// is at most 2^-32 too large, under 1/256 px per frame at ZIP_SPEED_CURVE_MAX_SPEED.
+#define ZIP_SPEED_CURVE_SCALE_32_32(num, den) ((((uint64_t)(num) << 32) + (den) - 1) / (den))
+#define ZIP_SPEED_CURVE_SCALE_16_16(num, den) ((((uint64_t)(num) << 16) + (den) - 1) / (den))
+
+/**
+ * @brief Interpolation between curve points
+ */
+enum zip_speed_curve_interpolation {
+    ZIP_SPEED_CURVE_INTERP_LINEAR,  // Linear between neighbouring points
+    ZIP_SPEED_CURVE_INTERP_STEP,    // Hold each point's speed until the next point
+};
+
+/**
+ * @brief Speed curve selectable through the profile parameter
+ */
+struct zip_speed_curve_profile {
+    const int32_t *curve_points;    // Array of [time_ms, speed] pairs
+    size_t curve_points_len;        // Number of curve points (pairs)
+    const int32_t *slopes;          // Per-segment slope in px/s per ms (16.16), or NULL
+    const int32_t *lut;             // Speeds every (1 << lut_shift) ms, or NULL
+    uint16_t lut_len;               // Number of LUT entries
+    uint8_t lut_shift;              // log2 of the LUT step in ms, or mantissa bits if lut_log
+    bool lut_log;                   // LUT step doubles every octave (see below)
+    uint8_t interpolation;          // enum zip_speed_curve_interpolation
+};
+
+/*
+ * Log-spaced LUT: with b = lut_shift, positions below 2^(b + 1) have one entry
+ * per ms and every further octave [2^(b + e), 2^(b + e + 1)) adds 2^b entries
+ * 2^e ms apart. Position t is found at (e << b) + (t >> e) with
+ * e = max(0, msb(t) - b), without a search.
+ */
+
+/**
+ * @brief Check that a profile can be evaluated without overflow
+ *
+ * Requires at least two points, non-negative times in strictly increasing
+ * order and speeds between 0 and ZIP_SPEED_CURVE_MAX_SPEED. Precomputed
+ * slopes must match the points, LUT entries must be valid speeds and
+ * lut_shift must be below ZIP_SPEED_CURVE_FRAC_BITS.
+ */
+bool zip_speed_curve_profile_valid(const struct zip_speed_curve_profile *profile);
+
+/**
+ * @brief Calculate speed at a curve position
+ *
+ * Uses the profile's precomputed LUT and slopes where present.
+ *
+ * @param profile Profile containing curve points
+ * @param elapsed_ms Curve position (elapsed ms, or the curve-input's unit)
+ * @return Speed in pixels per second
+ */
+int32_t zip_speed_curve_eval(const struct zip_speed_curve_profile *profile, int64_t elapsed_ms);
+
+// zip_speed_curve_search_depth() as a constant expression, for up to 1025 points
+#define ZIP_SPEED_CURVE_SEARCH_DEPTH(num_points)                                        \
+    (((num_points) > 2) + ((num_points) > 3) + ((num_points) > 5) + ((num_points) > 9) +  \
+     ((num_points) > 17) + ((num_points) > 33) + ((num_points) > 65) +                  \
+     ((num_points) > 129) + ((num_points) > 257) + ((num_points) > 513))
+
+/**
+ * @brief Worst-case segment search steps of zip_speed_curve_eval()
+ *
+ * Evaluation runs in constant time apart from a binary search over the
+ * curve's segments; this bounds its iterations for a point count.
+ */
+unsigned int zip_speed_curve_search_depth(size_t num_points);
+
+/**
+ * @brief Calculate speed at a curve position from the curve points alone
+ *
+ * Ignores the LUT and slopes, so it gives the result every precomputed
+ * engine is meant to approximate.
+ */
+int32_t zip_speed_curve_eval_reference(const struct zip_speed_curve_profile *profile,
+                                       int64_t elapsed_ms);
+
+/**
+ * @brief Convert a fixed-point movement to whole pixels
+ *
+ * With remainder tracking the fractional part is carried into the next
+ * event, so the emitted total never drifts from the computed distance.
+ *
+ * @param movement Movement in pixels with ZIP_SPEED_CURVE_FRAC_BITS fraction bits
+ */
+int64_t zip_speed_curve_track_remainder(int64_t movement, int32_t *remainder, bool track);
+
+/**
+ * @brief Multiply, saturating at the int64_t range instead of overflowing
+ */
+int64_t zip_speed_curve_mul_sat(int64_t a, int64_t b);
+
+/**
+ * @brief Apply a ZIP_SPEED_CURVE_GAIN() cell to a fixed-point movement
+ *
+ * @param gain Packed gain, 0 for unity
+ */
+int64_t zip_speed_curve_apply_gain(int64_t movement, uint32_t gain);
+
+/**
+ * @brief Integer square root (floor)
+ */
+uint32_t zip_speed_curve_isqrt64(uint64_t value);
+
+/**
+ * @brief Squared length of a pair of axis values, x * x + y * y
+ *
+ * Exact for any values above INT32_MIN. With
+ * CONFIG_ZMK_INPUT_PROCESSOR_SPEED_CURVE_DSP, pairs that both fit 16 bits
+ * take a single SMUAD (src/speed_curve_engine_dsp.c).
+ */
+uint64_t zip_speed_curve_norm_sq2(int32_t x, int32_t y);
+
+/**
+ * @brief Portable C version of zip_speed_curve_norm_sq2()
+ */
+uint64_t zip_speed_curve_norm_sq2_portable(int32_t x, int32_t y);
+
+/**
+ * @brief Smoothing factor of a first-order low-pass filter
+ *
+ * alpha = r / (1 + r) with r = 2 * pi * cutoff * interval, computed as
+ * integers with r scaled by 1e9. r saturates where alpha is 1 for all
+ * practical purposes, so any cutoff and interval are safe.
+ *
+ * @param cutoff_mhz Cutoff frequency in mHz
+ * @param interval_us Sample interval in us
+ * @return alpha with ZIP_SPEED_CURVE_FRAC_BITS fraction bits
+ */
+int64_t zip_speed_curve_lowpass_alpha(int64_t cutoff_mhz, int64_t interval_us);
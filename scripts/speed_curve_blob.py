@@ -0,0 +1,260 @@
+#!/usr/bin/env python3
+# Copyright (c) 2024 The ZMK Contributors
+# SPDX-License-Identifier: MIT
+
+"""Compile a speed curve into a blob for a curve-partition.
+
+The curve is given in the same form as the curve-points devicetree
+property, e.g.:
+
+    speed_curve_blob.py "<0 50>, <300 200>, <1000 800>" -o curve.bin
+
+The layout matches struct zip_speed_curve_blob_header in
+include/zmk/input_processors/speed_curve.h. A lookup table can be added
+with uniform or log-spaced steps; log spacing keeps 1 ms steps near t = 0,
+where curves usually change fastest, and doubles the step every octave
+after that. With --max-error and/or --lut-budget the step is chosen
+automatically: the smallest table whose error against exact interpolation
+stays within the bound, or the finest table that fits the budget. With --hex-address the blob is
+written as Intel HEX at the partition's flash address instead, ready for
+the usual flashing tools.
+"""
+
+import argparse
+import re
+import struct
+import sys
+import zlib
+
+BLOB_MAGIC = 0x4243535A
+BLOB_VERSION = 1
+BLOB_LUT_LOG = 0x80
+MAX_LUT_LEN = 0xFFFF
+HEADER_FORMAT = "<IHBBHHII"
+FRAC_BITS = 16
+MAX_SPEED = (1 << 24) - 1  # ZIP_SPEED_CURVE_MAX_SPEED
+MAX_TIME = (1 << 31) - 1
+DEFAULT_MAX_POINTS = 32    # CONFIG_ZMK_INPUT_PROCESSOR_SPEED_CURVE_MAX_POINTS default
+
+INTERPOLATION = {"linear": 0, "step": 1}
+
+
+def c_div(a, b):
+    """Integer division truncating toward zero, as in C."""
+    q = abs(a) // abs(b)
+    return q if (a < 0) == (b < 0) else -q
+
+
+def parse_points(text, max_points=DEFAULT_MAX_POINTS):
+    """Parse and check points the way zip_speed_curve_profile_valid() does at boot."""
+    values = [int(v, 0) for v in re.findall(r"-?(?:0x[0-9a-fA-F]+|\d+)", text)]
+    if len(values) < 4 or len(values) % 2:
+        raise ValueError("expected at least 2 [time_ms speed] pairs")
+    points = list(zip(values[::2], values[1::2]))
+    if len(points) > max_points:
+        raise ValueError(f"{len(points)} points, the firmware accepts at most {max_points} "
+                         "(CONFIG_ZMK_INPUT_PROCESSOR_SPEED_CURVE_MAX_POINTS)")
+    for t, s in points:
+        if not 0 <= t <= MAX_TIME:
+            raise ValueError(f"time {t} is out of range (0 to {MAX_TIME})")
+        if not 0 <= s <= MAX_SPEED:
+            raise ValueError(f"speed {s} at {t} ms is out of range (0 to {MAX_SPEED})")
+    for (t0, _), (t1, _) in zip(points, points[1:]):
+        if t1 <= t0:
+            raise ValueError(f"points must be sorted by time ({t0} >= {t1})")
+    return points
+
+
+def speed_at(points, interpolation, t):
+    """Same result as the firmware's division-based engine."""
+    if t <= points[0][0]:
+        return points[0][1]
+    if t >= points[-1][0]:
+        return points[-1][1]
+    for (t0, s0), (t1, s1) in zip(points, points[1:]):
+        if t0 <= t <= t1:
+            if interpolation == INTERPOLATION["step"]:
+                return s0 if t < t1 else s1
+            return s0 + c_div((s1 - s0) * (t - t0), t1 - t0)
+    return points[-1][1]
+
+
+def lut_step(t, log_spacing, shift):
+    """Table index and log2 of the step at time t, as the firmware computes them."""
+    if not log_spacing:
+        return t >> shift, shift
+    e = max(t.bit_length() - 1 - shift, 0)
+    return (e << shift) + (t >> e), e
+
+
+def lut_time(index, log_spacing, shift):
+    """Time of a table entry (inverse of lut_step)."""
+    if not log_spacing:
+        return index << shift
+    e = max((index >> shift) - 1, 0)
+    return (index - (e << shift)) << e
+
+
+def lut_len(lut_until, log_spacing, shift):
+    return lut_step(lut_until, log_spacing, shift)[0] + 2
+
+
+def build_lut(points, interpolation, log_spacing, shift, lut_until):
+    return [speed_at(points, interpolation, lut_time(i, log_spacing, shift))
+            for i in range(lut_len(lut_until, log_spacing, shift))]
+
+
+def lut_error(points, interpolation, lut, log_spacing, shift):
+    """Largest difference between the firmware's table lookup and exact interpolation."""
+    error = 0
+    for t in range(points[0][0] + 1, points[-1][0]):
+        index, step = lut_step(t, log_spacing, shift)
+        if index + 1 >= len(lut):
+            break
+        s0, s1 = lut[index], lut[index + 1]
+        value = s0 + (((s1 - s0) * (t & ((1 << step) - 1))) >> step)
+        error = max(error, abs(value - speed_at(points, interpolation, t)))
+    return error
+
+
+def choose_lut_shift(points, interpolation, log_spacing, lut_until, max_error, budget):
+    """Smallest table within max_error, or the finest one within budget."""
+    best = None
+    for shift in range(FRAC_BITS):
+        length = lut_len(lut_until, log_spacing, shift)
+        if length > MAX_LUT_LEN or (budget is not None and length * 4 > budget):
+            continue
+        if max_error is None:
+            if best is None or length > best[1]:
+                best = (shift, length)
+            continue
+        lut = build_lut(points, interpolation, log_spacing, shift, lut_until)
+        if lut_error(points, interpolation, lut, log_spacing, shift) <= max_error:
+            if best is None or length < best[1]:
+                best = (shift, length)
+    return None if best is None else best[0]
+
+
+def curve_slopes(points):
+    """Per-segment slopes in 16.16 px/s per ms, as stored in the blob."""
+    return [c_div((s1 - s0) << FRAC_BITS, t1 - t0)
+            for (t0, s0), (t1, s1) in zip(points, points[1:])]
+
+
+def build_blob(points, interpolation, lut_shift, lut_until, log_spacing=False):
+    slopes = curve_slopes(points)
+
+    lut = []
+    if lut_until is not None:
+        lut = build_lut(points, interpolation, log_spacing, lut_shift, lut_until)
+
+    words = [v for point in points for v in point] + slopes + lut
+    payload = struct.pack(f"<{len(words)}i", *words)
+    header = struct.pack(HEADER_FORMAT, BLOB_MAGIC, BLOB_VERSION, interpolation,
+                         lut_shift | (BLOB_LUT_LOG if log_spacing else 0), len(points),
+                         len(lut), len(payload), zlib.crc32(payload) & 0xFFFFFFFF)
+    return header + payload
+
+
+def intel_hex(data, address):
+    def record(rtype, addr, payload):
+        body = bytes([len(payload), (addr >> 8) & 0xFF, addr & 0xFF, rtype]) + payload
+        return ":" + (body + bytes([-sum(body) & 0xFF])).hex().upper()
+
+    lines = []
+    upper = None
+    for offset in range(0, len(data), 16):
+        addr = address + offset
+        if addr >> 16 != upper:
+            upper = addr >> 16
+            lines.append(record(4, 0, struct.pack(">H", upper)))
+        lines.append(record(0, addr & 0xFFFF, data[offset:offset + 16]))
+    lines.append(record(1, 0, b""))
+    return "\n".join(lines) + "\n"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("points", help='curve points, e.g. "<0 50>, <300 200>"')
+    parser.add_argument("-o", "--output", required=True, help="output file")
+    parser.add_argument("--interpolation", choices=INTERPOLATION, default="linear")
+    parser.add_argument("--lut-until", type=int, metavar="MS",
+                        help="precompute a lookup table covering 0..MS (default with --lut-spacing, "
+                             "--max-error or --lut-budget: the last point's time)")
+    parser.add_argument("--lut-spacing", choices=("linear", "log"), default="linear",
+                        help="uniform steps, or 1 ms steps doubling every octave (default: linear)")
+    parser.add_argument("--lut-shift", type=int,
+                        help="log2 of the uniform step in ms, or the mantissa bits of a log-spaced "
+                             "table (default: chosen from --max-error/--lut-budget, else 3)")
+    parser.add_argument("--max-error", type=int, metavar="SPEED",
+                        help="largest allowed lookup error against exact interpolation, in px/s")
+    parser.add_argument("--lut-budget", type=int, metavar="BYTES",
+                        help="largest allowed lookup table size in bytes")
+    parser.add_argument("--max-points", type=int, default=DEFAULT_MAX_POINTS, metavar="N",
+                        help="CONFIG_ZMK_INPUT_PROCESSOR_SPEED_CURVE_MAX_POINTS of the firmware "
+                             f"(default: {DEFAULT_MAX_POINTS})")
+    parser.add_argument("--hex-address", type=lambda v: int(v, 0), metavar="ADDR",
+                        help="write Intel HEX at this flash address instead of raw binary")
+    args = parser.parse_args()
+
+    if args.lut_shift is not None and not 0 <= args.lut_shift < FRAC_BITS:
+        parser.error(f"--lut-shift must be between 0 and {FRAC_BITS - 1}")
+
+    try:
+        points = parse_points(args.points, args.max_points)
+    except ValueError as e:
+        parser.error(str(e))
+
+    for slope, (t0, _), (t1, _) in zip(curve_slopes(points), points, points[1:]):
+        if not -2**31 <= slope < 2**31:
+            parser.error(f"segment {t0}..{t1} ms is too steep for a 16.16 slope, "
+                         "spread the points further apart")
+
+    interpolation = INTERPOLATION[args.interpolation]
+    log_spacing = args.lut_spacing == "log"
+    lut_until = args.lut_until
+    if lut_until is None and (log_spacing or args.max_error is not None or
+                              args.lut_budget is not None):
+        lut_until = points[-1][0]
+    if lut_until is not None and lut_until < 0:
+        parser.error("--lut-until must not be negative")
+    if lut_until is not None and interpolation == INTERPOLATION["step"]:
+        parser.error("step curves cannot use a lookup table, it would ramp between steps")
+
+    lut_shift = args.lut_shift
+    if lut_shift is None:
+        lut_shift = 3
+        if lut_until is not None and (args.max_error is not None or args.lut_budget is not None):
+            lut_shift = choose_lut_shift(points, interpolation, log_spacing, lut_until,
+                                         args.max_error, args.lut_budget)
+            if lut_shift is None:
+                parser.error("no lookup table meets --max-error within --lut-budget")
+
+    if lut_until is not None:
+        length = lut_len(lut_until, log_spacing, lut_shift)
+        if length > MAX_LUT_LEN:
+            parser.error("lookup table too long, increase --lut-shift")
+        if args.lut_budget is not None and length * 4 > args.lut_budget:
+            parser.error(f"lookup table needs {length * 4} bytes, over --lut-budget")
+        lut = build_lut(points, interpolation, log_spacing, lut_shift, lut_until)
+        error = lut_error(points, interpolation, lut, log_spacing, lut_shift)
+        if args.max_error is not None and error > args.max_error:
+            parser.error(f"lookup error {error} px/s exceeds --max-error")
+        print(f"lookup table: {args.lut_spacing}, shift {lut_shift}, {length} entries "
+              f"({length * 4} bytes), max error {error} px/s", file=sys.stderr)
+
+    blob = build_blob(points, interpolation, lut_shift, lut_until, log_spacing)
+
+    if args.hex_address is not None:
+        with open(args.output, "w") as f:
+            f.write(intel_hex(blob, args.hex_address))
+    else:
+        with open(args.output, "wb") as f:
+            f.write(blob)
+
+    print(f"{args.output}: {len(points)} points, {len(blob)} bytes", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
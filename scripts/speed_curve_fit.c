@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Host-side scoring of candidate curves for scripts/speed_curve_fit.py.
+ *
+ * Built together with src/speed_curve_engine.c into a shared library, so
+ * candidates are evaluated by the same curve and remainder code as the
+ * firmware. The event handling around it follows the processor for
+ * curve-input = "time": per-axis timing, reset on stop, reversal and
+ * timeout, and remainder tracking.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <zmk/input_processors/speed_curve_engine.h>
+
+// Same as ZIP_SPEED_CURVE_TIMEOUT_MS in the processor
+#define TIMEOUT_MS 50
+
+struct fit_event {
+    int64_t time;                   // Uptime in ms
+    int32_t axis;                   // 0 for X, 1 for Y
+    int32_t value;                  // Raw event value
+};
+
+struct fit_target {
+    int64_t start;                  // First event time of the acquisition
+    int64_t end;                    // Time the target was reached in the recording
+    double dx;                      // Displacement to the target in px
+    double dy;
+    size_t first;                   // First event between start and end
+    size_t count;                   // Number of events between start and end
+};
+
+struct fit_weights {
+    double tolerance;               // Distance in px that counts as on target
+    double overshoot;               // Cost per px of overshoot
+    double error;                   // Cost per px of distance left at the end
+    double miss;                    // Cost in ms of never reaching the target
+};
+
+struct fit_axis {
+    int64_t start_time;
+    int64_t last_event_time;
+    int32_t remainder;
+    int8_t last_direction;
+    bool started;
+};
+
+/**
+ * @brief Replay one acquisition and return its cost
+ *
+ * Cost is the time until the output first comes within tolerance of the
+ * target, plus weighted overshoot along the target direction and the
+ * distance still left when the recording reached the target.
+ */
+static double score_target(const struct zip_speed_curve_profile *profile, uint64_t movement_scale,
+                           const struct fit_event *events, const struct fit_target *target,
+                           const struct fit_weights *weights) {
+    struct fit_axis axes[2] = {0};
+    double pos[2] = {0, 0};
+    double length = hypot(target->dx, target->dy);
+    double reached = -1;
+    double overshoot = 0;
+
+    // Only the target's own events, as sliced by speed_curve_fit.py
+    for (size_t i = target->first; i < target->first + target->count; i++) {
+        const struct fit_event *event = &events[i];
+        struct fit_axis *axis = &axes[event->axis];
+        int8_t direction = (event->value > 0) - (event->value < 0);
+
+        if (axis->last_event_time != 0 && event->time - axis->last_event_time > TIMEOUT_MS) {
+            axis->started = false;
+            axis->remainder = 0;
+        }
+        axis->last_event_time = event->time;
+
+        if (direction == 0 || (axis->last_direction != 0 && direction != axis->last_direction)) {
+            axis->started = false;
+            axis->remainder = 0;
+        }
+        axis->last_direction = direction;
+        if (direction == 0) {
+            continue;
+        }
+
+        if (!axis->started) {
+            axis->start_time = event->time;
+            axis->started = true;
+        }
+
+        int32_t speed = zip_speed_curve_eval(profile, event->time - axis->start_time);
+        int64_t movement = zip_speed_curve_mul_sat(speed, movement_scale) >>
+                           (32 - ZIP_SPEED_CURVE_FRAC_BITS);
+        if (movement > ZIP_SPEED_CURVE_MAX_MOVEMENT) {
+            movement = ZIP_SPEED_CURVE_MAX_MOVEMENT;
+        }
+        pos[event->axis] += direction * zip_speed_curve_track_remainder(movement, &axis->remainder,
+                                                                        true);
+
+        double dist = hypot(target->dx - pos[0], target->dy - pos[1]);
+        if (reached < 0 && dist <= weights->tolerance) {
+            reached = event->time - target->start;
+        }
+        if (length > 0) {
+            double along = (pos[0] * target->dx + pos[1] * target->dy) / length;
+            overshoot = fmax(overshoot, along - length);
+        }
+    }
+
+    double error = hypot(target->dx - pos[0], target->dy - pos[1]);
+    if (reached < 0) {
+        reached = (target->end - target->start) + weights->miss;
+    }
+
+    return reached + weights->overshoot * overshoot + weights->error * error;
+}
+
+/**
+ * @brief Score a batch of candidate curves sharing the same point times
+ *
+ * @param times Point times, num_points entries
+ * @param speeds Candidate speeds, num_points entries per candidate
+ * @param events Events sorted by time
+ * @param targets Acquisitions, each with the slice of events it replays
+ * @param costs Mean cost per acquisition for each candidate, or INFINITY if
+ *              the candidate is not a valid curve
+ */
+void fit_score_batch(const int32_t *times, size_t num_points, const int32_t *speeds,
+                     size_t num_candidates, uint64_t movement_scale, const struct fit_event *events,
+                     size_t num_events, const struct fit_target *targets, size_t num_targets,
+                     const struct fit_weights *weights, double *costs) {
+    int32_t *points = malloc(num_points * 2 * sizeof(*points));
+    if (points == NULL) {
+        for (size_t c = 0; c < num_candidates; c++) {
+            costs[c] = INFINITY;
+        }
+        return;
+    }
+
+    for (size_t c = 0; c < num_candidates; c++) {
+        for (size_t i = 0; i < num_points; i++) {
+            points[i * 2] = times[i];
+            points[i * 2 + 1] = speeds[c * num_points + i];
+        }
+
+        struct zip_speed_curve_profile profile = {
+            .curve_points = points,
+            .curve_points_len = num_points * 2,
+            .interpolation = ZIP_SPEED_CURVE_INTERP_LINEAR,
+        };
+        if (!zip_speed_curve_profile_valid(&profile)) {
+            costs[c] = INFINITY;
+            continue;
+        }
+
+        double total = 0;
+        for (size_t t = 0; t < num_targets; t++) {
+            if (targets[t].first + targets[t].count > num_events) {
+                total = INFINITY;
+                break;
+            }
+            total += score_target(&profile, movement_scale, events, &targets[t], weights);
+        }
+        costs[c] = num_targets > 0 ? total / num_targets : 0;
+    }
+
+    free(points);
+}
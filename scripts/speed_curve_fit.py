@@ -0,0 +1,259 @@
+#!/usr/bin/env python3
+# Copyright (c) 2024 The ZMK Contributors
+# SPDX-License-Identifier: MIT
+
+"""Fit curve-points to recorded input.
+
+Takes an event stream decoded by speed_curve_trace.py and a marker file
+describing what each movement was aiming for, and searches for the curve
+speeds that reach those targets fastest without overshooting:
+
+    speed_curve_fit.py events.txt markers.txt --times 0,100,300,600,1000
+
+Each line of the marker file is "start_ms end_ms dx dy": an acquisition
+started at start_ms, the target was dx/dy px away and the recording
+reached it at end_ms. The recorded key timing is replayed for every
+candidate curve (curve-input = "time"), and a candidate's cost is the
+mean time until the cursor gets within --tolerance of the target, plus
+weighted overshoot and remaining distance.
+
+Candidates are scored by src/speed_curve_engine.c itself: it is compiled
+for the host together with speed_curve_fit.c, and batches are scored on
+all cores. The result is printed as a devicetree snippet.
+"""
+
+import argparse
+import bisect
+import ctypes
+import os
+import random
+import subprocess
+import sys
+import tempfile
+import time
+from concurrent.futures import ThreadPoolExecutor
+
+REPO = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+INPUT_EV_REL = 2
+MAX_SPEED = (1 << 24) - 1
+HI_RES_UNITS_PER_NOTCH = 120  # ZIP_SPEED_CURVE_HI_RES_UNITS_PER_NOTCH
+
+
+class FitEvent(ctypes.Structure):
+    _fields_ = [("time", ctypes.c_int64), ("axis", ctypes.c_int32), ("value", ctypes.c_int32)]
+
+
+class FitTarget(ctypes.Structure):
+    _fields_ = [("start", ctypes.c_int64), ("end", ctypes.c_int64),
+                ("dx", ctypes.c_double), ("dy", ctypes.c_double),
+                ("first", ctypes.c_size_t), ("count", ctypes.c_size_t)]
+
+
+class FitWeights(ctypes.Structure):
+    _fields_ = [("tolerance", ctypes.c_double), ("overshoot", ctypes.c_double),
+                ("error", ctypes.c_double), ("miss", ctypes.c_double)]
+
+
+def build_library(workdir):
+    """Compile the firmware curve engine and the scoring harness for the host."""
+    lib = os.path.join(workdir, "speed_curve_fit.so")
+    cmd = [os.environ.get("CC", "cc"), "-O2", "-shared", "-fPIC",
+           "-I", os.path.join(REPO, "include"),
+           os.path.join(REPO, "src", "speed_curve_engine.c"),
+           os.path.join(REPO, "scripts", "speed_curve_fit.c"),
+           "-o", lib, "-lm"]
+    subprocess.run(cmd, check=True)
+
+    dll = ctypes.CDLL(lib)
+    dll.fit_score_batch.restype = None
+    dll.fit_score_batch.argtypes = [
+        ctypes.POINTER(ctypes.c_int32), ctypes.c_size_t, ctypes.POINTER(ctypes.c_int32),
+        ctypes.c_size_t, ctypes.c_uint64, ctypes.POINTER(FitEvent), ctypes.c_size_t,
+        ctypes.POINTER(FitTarget), ctypes.c_size_t, ctypes.POINTER(FitWeights),
+        ctypes.POINTER(ctypes.c_double)]
+    return dll
+
+
+def read_events(path, event_type, codes):
+    events = []
+    with open(path) as f:
+        for line in f:
+            fields = line.split("#")[0].split()
+            if len(fields) < 5:
+                continue
+            t, etype, code, value = (int(v) for v in fields[:4])
+            if etype == event_type and code in codes:
+                events.append((t, codes.index(code), value))
+    # Stable, so events of the same millisecond keep their order
+    events.sort(key=lambda e: e[0])
+    return events
+
+
+def read_targets(path):
+    targets = []
+    with open(path) as f:
+        for line in f:
+            line = line.split("#")[0].split()
+            if line:
+                start, end, dx, dy = line
+                targets.append((int(start), int(end), float(dx), float(dy)))
+    return targets
+
+
+def event_slices(events, targets):
+    """Targets with the range of events each one replays, found once by bisection."""
+    times = [e[0] for e in events]
+    slices = []
+    for start, end, dx, dy in targets:
+        first = bisect.bisect_left(times, start)
+        last = bisect.bisect_right(times, end)
+        slices.append((start, end, dx, dy, first, last - first))
+    return slices
+
+
+def movement_scale(trigger_period_ms, multiplier, divisor, hi_res_scroll=False):
+    """Same as ZIP_SPEED_CURVE_MOVEMENT_SCALE() in src/speed_curve.c.
+
+    px/event per px/s as a 32.32 fixed-point factor, rounded up like
+    ZIP_SPEED_CURVE_SCALE_32_32(), in hi-res wheel units with hi_res_scroll.
+    """
+    units = HI_RES_UNITS_PER_NOTCH if hi_res_scroll else 1
+    num = trigger_period_ms * multiplier * units
+    den = 1000 * divisor
+    return ((num << 32) + den - 1) // den
+
+
+class Scorer:
+    def __init__(self, dll, times, scale, events, targets, weights, jobs):
+        self.dll = dll
+        self.num_points = len(times)
+        self.times = (ctypes.c_int32 * len(times))(*times)
+        self.scale = scale
+        self.events = (FitEvent * len(events))(*events)
+        self.targets = (FitTarget * len(targets))(*targets)
+        self.weights = FitWeights(*weights)
+        self.jobs = jobs
+        self.pool = ThreadPoolExecutor(max_workers=jobs)
+
+    def score_chunk(self, chunk):
+        speeds = (ctypes.c_int32 * (len(chunk) * self.num_points))(
+            *(s for candidate in chunk for s in candidate))
+        costs = (ctypes.c_double * len(chunk))()
+        # ctypes releases the GIL for the call, so chunks run in parallel
+        self.dll.fit_score_batch(self.times, self.num_points, speeds, len(chunk), self.scale,
+                                 self.events, len(self.events), self.targets, len(self.targets),
+                                 ctypes.byref(self.weights), costs)
+        return list(costs)
+
+    def score(self, candidates):
+        size = max(1, -(-len(candidates) // self.jobs))
+        chunks = [candidates[i:i + size] for i in range(0, len(candidates), size)]
+        return [c for costs in self.pool.map(self.score_chunk, chunks) for c in costs]
+
+
+def mutate(speeds, spread, min_speed, max_speed):
+    candidate = [min(max_speed, max(min_speed, round(s * random.lognormvariate(0, spread))))
+                 for s in speeds]
+    # Acceleration curves only speed up
+    return sorted(candidate)
+
+
+def search(scorer, start, args):
+    population = [start] + [sorted(random.randint(args.min_speed, args.max_speed)
+                                   for _ in start) for _ in range(args.population - 1)]
+    scored = sorted(zip(scorer.score(population), population))
+    evaluated = len(population)
+    began = time.monotonic()
+
+    for generation in range(args.generations):
+        spread = args.spread * (1 - generation / args.generations) + 0.01
+        elite = [c for _, c in scored[:args.elite]]
+        children = [mutate(random.choice(elite), spread, args.min_speed, args.max_speed)
+                    for _ in range(args.population - len(elite))]
+        scored = sorted(scored[:args.elite] + list(zip(scorer.score(children), children)))
+        evaluated += len(children)
+
+        if args.verbose:
+            print(f"generation {generation + 1}: cost {scored[0][0]:.1f}", file=sys.stderr)
+
+    rate = evaluated / max(time.monotonic() - began, 1e-6)
+    print(f"{evaluated} candidates, {rate:.0f}/s", file=sys.stderr)
+    return scored[0]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("events", help="event stream from speed_curve_trace.py")
+    parser.add_argument("markers", help='acquisition markers, "start_ms end_ms dx dy" per line')
+    parser.add_argument("--times", default="0,100,300,600,1000",
+                        help="curve point times in ms (default: %(default)s)")
+    parser.add_argument("--start", help="initial speeds, one per point time")
+    parser.add_argument("--type", type=int, default=INPUT_EV_REL, help="event type")
+    parser.add_argument("--codes", default="0,1", help="X and Y event codes")
+    parser.add_argument("--trigger-period-ms", type=int, default=16)
+    parser.add_argument("--scale-multiplier", type=int, default=1)
+    parser.add_argument("--scale-divisor", type=int, default=1)
+    parser.add_argument("--hi-res-scroll", action="store_true",
+                        help="the instance has hi-res-scroll (120 units per notch)")
+    parser.add_argument("--min-speed", type=int, default=1)
+    parser.add_argument("--max-speed", type=int, default=5000)
+    parser.add_argument("--tolerance", type=float, default=4, help="on-target radius in px")
+    parser.add_argument("--overshoot-weight", type=float, default=2,
+                        help="cost in ms per px of overshoot")
+    parser.add_argument("--error-weight", type=float, default=1,
+                        help="cost in ms per px left at the end")
+    parser.add_argument("--miss-penalty", type=float, default=500,
+                        help="extra cost in ms when the target is never reached")
+    parser.add_argument("--generations", type=int, default=200)
+    parser.add_argument("--population", type=int, default=512)
+    parser.add_argument("--elite", type=int, default=16)
+    parser.add_argument("--spread", type=float, default=0.5, help="initial mutation spread")
+    parser.add_argument("--jobs", type=int, default=os.cpu_count() or 1)
+    parser.add_argument("--seed", type=int)
+    parser.add_argument("-v", "--verbose", action="store_true")
+    args = parser.parse_args()
+
+    times = [int(t) for t in args.times.split(",")]
+    codes = [int(c) for c in args.codes.split(",")]
+    if len(times) < 2 or times != sorted(set(times)) or times[0] < 0:
+        parser.error("--times must be at least 2 increasing, non-negative times")
+    if len(codes) != 2:
+        parser.error("--codes takes the X and Y code")
+    if not 0 <= args.min_speed <= args.max_speed <= MAX_SPEED:
+        parser.error(f"speeds must be within 0..{MAX_SPEED}")
+    if not 0 < args.elite < args.population:
+        parser.error("--elite must be between 1 and --population")
+
+    start = None
+    if args.start:
+        start = sorted(int(s) for s in args.start.split(","))
+        if len(start) != len(times):
+            parser.error("--start needs one speed per point time")
+    else:
+        start = [args.min_speed + (args.max_speed - args.min_speed) * i // (len(times) - 1)
+                 for i in range(len(times))]
+
+    events = read_events(args.events, args.type, codes)
+    targets = read_targets(args.markers)
+    if not events or not targets:
+        parser.error("no matching events or markers")
+    targets = event_slices(events, targets)
+
+    random.seed(args.seed)
+    with tempfile.TemporaryDirectory() as workdir:
+        dll = build_library(workdir)
+        scale = movement_scale(args.trigger_period_ms, args.scale_multiplier, args.scale_divisor,
+                               args.hi_res_scroll)
+        weights = (args.tolerance, args.overshoot_weight, args.error_weight, args.miss_penalty)
+        scorer = Scorer(dll, times, scale, events, targets, weights, args.jobs)
+        cost, speeds = search(scorer, start, args)
+
+    points = ", ".join(f"<{t} {s}>" for t, s in zip(times, speeds))
+    print(f"// Fitted to {len(targets)} acquisitions, mean cost {cost:.1f}")
+    print(f"trigger-period-ms = <{args.trigger_period_ms}>;")
+    print(f"curve-points = {points};")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,152 @@
+#!/usr/bin/env python3
+# Copyright (c) 2024 The ZMK Contributors
+# SPDX-License-Identifier: MIT
+
+"""Decode input traces captured by the speed curve processor.
+
+Traces are exported with the "speed_curve trace dump <device>" shell command
+(CONFIG_ZMK_INPUT_PROCESSOR_SPEED_CURVE_TRACE). Save the shell output, from
+one or more dumps in order, and decode it into one event per line:
+
+    speed_curve_trace.py capture.log > events.txt
+
+Each output line is "time_ms type code value sync", the raw event as the
+processor received it, ready to be replayed into a host build of the
+processor or the curve engine at full speed. Shell prompts and log lines
+between the dump lines are ignored.
+
+The record layout matches trace_event() in src/speed_curve.c.
+"""
+
+import argparse
+import re
+import sys
+
+SLOT_TOUCH = 0x7E
+RESTART = 0xFF
+INPUT_EV_KEY = 1
+INPUT_BTN_TOUCH = 0x14A
+
+HEADER_RE = re.compile(r"trace (\S+) type (\d+) codes((?: \d+)*)\s*$")
+DATA_RE = re.compile(r"^(?:[0-9a-f]{2})+$")
+END_RE = re.compile(r"end (\d+) bytes, (\d+) records dropped")
+
+
+class Decoder:
+    """Decoding state of one device, kept across consecutive dumps."""
+
+    def __init__(self, event_type, codes):
+        self.event_type = event_type
+        self.codes = codes
+        self.pending = b""
+        self.restart()
+
+    def restart(self):
+        self.time = 0
+        self.values = [0] * len(self.codes)
+
+    def feed(self, data):
+        """Decode all complete records, keeping a partial one for the next dump."""
+        buf = self.pending + data
+        pos = 0
+        events = []
+        while pos < len(buf):
+            try:
+                event, pos = self.record(buf, pos)
+            except IndexError:
+                break
+            if event is not None:
+                events.append(event)
+        self.pending = buf[pos:]
+        return events
+
+    def record(self, buf, pos):
+        header = buf[pos]
+        if header == RESTART:
+            self.restart()
+            return None, pos + 1
+
+        slot, sync = header >> 1, header & 1
+        delta, pos = varint(buf, pos + 1)
+        value, pos = varint(buf, pos)
+        value = unzigzag(value)
+        self.time += delta
+
+        if slot == SLOT_TOUCH:
+            return (self.time, INPUT_EV_KEY, INPUT_BTN_TOUCH, value, sync), pos
+        if slot >= len(self.codes):
+            raise ValueError(f"record for unknown slot {slot}")
+
+        self.values[slot] += value
+        return (self.time, self.event_type, self.codes[slot], self.values[slot], sync), pos
+
+
+def varint(buf, pos):
+    value = 0
+    shift = 0
+    while True:
+        byte = buf[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if byte < 0x80:
+            return value, pos
+
+
+def unzigzag(value):
+    return (value >> 1) ^ -(value & 1)
+
+
+def decode(lines, device):
+    decoders = {}
+    current = None
+    for line in lines:
+        line = line.strip()
+        header = HEADER_RE.search(line)
+        if header:
+            name = header.group(1)
+            current = None
+            if device is None or name == device:
+                if name not in decoders:
+                    if decoders and device is None:
+                        raise ValueError("trace holds several devices, pick one with --device")
+                    codes = [int(c) for c in header.group(3).split()]
+                    decoders[name] = Decoder(int(header.group(2)), codes)
+                current = decoders[name]
+            continue
+
+        end = END_RE.search(line)
+        if end:
+            if current is not None and int(end.group(2)):
+                print(f"warning: {end.group(2)} records dropped before this point",
+                      file=sys.stderr)
+            current = None
+            continue
+
+        if current is not None and DATA_RE.match(line):
+            yield from current.feed(bytes.fromhex(line))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("input", nargs="?", type=argparse.FileType("r"), default=sys.stdin,
+                        help="saved shell output (default: stdin)")
+    parser.add_argument("--device", help="only decode this device's dumps")
+    parser.add_argument("--relative", action="store_true",
+                        help="start the time base at the first event")
+    args = parser.parse_args()
+
+    start = None
+    try:
+        for time, event_type, code, value, sync in decode(args.input, args.device):
+            if args.relative:
+                start = time if start is None else start
+                time -= start
+            print(time, event_type, code, value, sync)
+    except ValueError as e:
+        parser.error(str(e))
+
+
+if __name__ == "__main__":
+    main()
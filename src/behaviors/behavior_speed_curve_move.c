@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#define DT_DRV_COMPAT zmk_behavior_speed_curve_move
+
+#include <errno.h>
+#include <zephyr/device.h>
+#include <zephyr/kernel.h>
+#include <zephyr/input/input.h>
+#include <zephyr/logging/log.h>
+#include <drivers/behavior.h>
+
+#include <dt-bindings/zmk/pointing.h>
+#include <zmk/behavior.h>
+#include <zmk/input_processors/speed_curve_engine.h>
+
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+/**
+ * @brief Configuration for speed curve move behavior
+ */
+struct speed_curve_move_config {
+    struct zip_speed_curve_profile profile; // Curve driving the movement
+    uint16_t x_code;                // Code reported for X movement
+    uint16_t y_code;                // Code reported for Y movement
+    uint16_t trigger_period_ms;     // Period between movement reports in ms
+    uint64_t movement_scale;        // px/report per px/s (32.32 fixed point, incl. scaler)
+};
+
+/**
+ * @brief Runtime state for one axis
+ */
+struct speed_curve_move_axis {
+    int32_t value;                  // Sum of the held bindings' directions on this axis
+    int64_t start_time;             // Uptime when the axis started moving in its direction
+    int32_t remainder;              // Sub-pixel remainder (ZIP_SPEED_CURVE_FRAC_BITS fraction)
+};
+
+/**
+ * @brief Runtime data for speed curve move behavior
+ */
+struct speed_curve_move_data {
+    const struct device *dev;       // This behavior, the device movement is reported from
+    struct k_work_delayable tick_work; // Reports movement while any direction is held
+    struct speed_curve_move_axis axes[2]; // X and Y
+};
+
+/**
+ * @brief Movement of one axis for the current report, in whole pixels
+ */
+static int32_t axis_movement(const struct speed_curve_move_config *cfg,
+                             struct speed_curve_move_axis *axis, int64_t now) {
+    int32_t speed = zip_speed_curve_eval(&cfg->profile, now - axis->start_time);
+    int64_t movement = zip_speed_curve_mul_sat(speed, cfg->movement_scale) >>
+                       (32 - ZIP_SPEED_CURVE_FRAC_BITS);
+
+    movement = MIN(movement, ZIP_SPEED_CURVE_MAX_MOVEMENT);
+    return (axis->value > 0 ? 1 : -1) *
+           zip_speed_curve_track_remainder(movement, &axis->remainder, true);
+}
+
+static void tick_work_cb(struct k_work *work) {
+    struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+    struct speed_curve_move_data *data =
+        CONTAINER_OF(dwork, struct speed_curve_move_data, tick_work);
+    const struct speed_curve_move_config *cfg = data->dev->config;
+    int64_t now = k_uptime_get();
+    int32_t move[2] = {0, 0};
+    bool active = false;
+
+    for (size_t i = 0; i < ARRAY_SIZE(data->axes); i++) {
+        if (data->axes[i].value != 0) {
+            move[i] = axis_movement(cfg, &data->axes[i], now);
+            active = true;
+        }
+    }
+
+    if (!active) {
+        return;
+    }
+
+    // One frame for both axes; frames the remainder absorbs entirely are not reported
+    if (move[0] != 0) {
+        input_report_rel(data->dev, cfg->x_code, move[0], move[1] == 0, K_FOREVER);
+    }
+    if (move[1] != 0) {
+        input_report_rel(data->dev, cfg->y_code, move[1], true, K_FOREVER);
+    }
+
+    k_work_reschedule(dwork, K_MSEC(cfg->trigger_period_ms));
+}
+
+/**
+ * @brief Add a binding's component to an axis
+ *
+ * The curve starts over when the axis starts moving or reverses.
+ */
+static void update_axis(struct speed_curve_move_axis *axis, int16_t delta, int64_t now) {
+    int32_t before = axis->value;
+
+    axis->value += delta;
+    if (axis->value == 0 || before == 0 || (before > 0) != (axis->value > 0)) {
+        axis->start_time = now;
+        axis->remainder = 0;
+    }
+}
+
+/**
+ * @brief Apply a binding's direction to both axes
+ *
+ * @param sign 1 when the binding is pressed, -1 when it is released
+ */
+static int update_binding(struct zmk_behavior_binding *binding, int sign) {
+    const struct device *dev = zmk_behavior_get_binding(binding->behavior_dev);
+    struct speed_curve_move_data *data = dev->data;
+    int64_t now = k_uptime_get();
+    bool was_active = data->axes[0].value != 0 || data->axes[1].value != 0;
+
+    // Only the direction of each component counts, so &mmv's MOVE_* values work as is
+    int16_t x = MOVE_X_DECODE(binding->param1);
+    int16_t y = MOVE_Y_DECODE(binding->param1);
+    update_axis(&data->axes[0], sign * ((x > 0) - (x < 0)), now);
+    update_axis(&data->axes[1], sign * ((y > 0) - (y < 0)), now);
+
+    if (!was_active && (data->axes[0].value != 0 || data->axes[1].value != 0)) {
+        k_work_reschedule(&data->tick_work, K_NO_WAIT);
+    }
+
+    return ZMK_BEHAVIOR_OPAQUE;
+}
+
+static int on_keymap_binding_pressed(struct zmk_behavior_binding *binding,
+                                     struct zmk_behavior_binding_event event) {
+    return update_binding(binding, 1);
+}
+
+static int on_keymap_binding_released(struct zmk_behavior_binding *binding,
+                                      struct zmk_behavior_binding_event event) {
+    return update_binding(binding, -1);
+}
+
+static const struct behavior_driver_api speed_curve_move_driver_api = {
+    .binding_pressed = on_keymap_binding_pressed,
+    .binding_released = on_keymap_binding_released,
+};
+
+static int speed_curve_move_init(const struct device *dev) {
+    const struct speed_curve_move_config *cfg = dev->config;
+    struct speed_curve_move_data *data = dev->data;
+
+    if (!zip_speed_curve_profile_valid(&cfg->profile)) {
+        LOG_ERR("%s: curve-points must be sorted by time, with times >= 0 and speeds "
+                "between 0 and %d",
+                dev->name, ZIP_SPEED_CURVE_MAX_SPEED);
+        return -EINVAL;
+    }
+
+    data->dev = dev;
+    k_work_init_delayable(&data->tick_work, tick_work_cb);
+
+    return 0;
+}
+
+#define SPEED_CURVE_MOVE_INST(n)                                                        \
+    BUILD_ASSERT(DT_INST_PROP_LEN(n, curve_points) >= 4 &&                             \
+                     DT_INST_PROP_LEN(n, curve_points) % 2 == 0,                       \
+                 "curve-points must hold at least two <time_ms speed> pairs");          \
+    BUILD_ASSERT(DT_INST_PROP(n, scale_divisor) > 0, "scale-divisor must be positive"); \
+    BUILD_ASSERT((uint64_t)DT_INST_PROP(n, trigger_period_ms) *                         \
+                         DT_INST_PROP(n, scale_multiplier) <                           \
+                     (1ULL << 31),                                                     \
+                 "trigger-period-ms * scale-multiplier is too large");                  \
+    static const int32_t speed_curve_move_points_##n[] = DT_INST_PROP(n, curve_points); \
+    static const struct speed_curve_move_config speed_curve_move_config_##n = {        \
+        .profile =                                                                      \
+            {                                                                           \
+                .curve_points = speed_curve_move_points_##n,                           \
+                .curve_points_len = DT_INST_PROP_LEN(n, curve_points),                 \
+                .interpolation = ZIP_SPEED_CURVE_INTERP_LINEAR,                        \
+            },                                                                          \
+        .x_code = DT_INST_PROP(n, x_input_code),                                       \
+        .y_code = DT_INST_PROP(n, y_input_code),                                       \
+        .trigger_period_ms = DT_INST_PROP(n, trigger_period_ms),                       \
+        .movement_scale = ZIP_SPEED_CURVE_SCALE_32_32(                                 \
+            (uint64_t)DT_INST_PROP(n, trigger_period_ms) * DT_INST_PROP(n, scale_multiplier), \
+            1000ULL * DT_INST_PROP(n, scale_divisor)),                                 \
+    };                                                                                  \
+    static struct speed_curve_move_data speed_curve_move_data_##n;                     \
+    BEHAVIOR_DT_INST_DEFINE(n, speed_curve_move_init, NULL, &speed_curve_move_data_##n, \
+                            &speed_curve_move_config_##n, POST_KERNEL,                 \
+                            CONFIG_KERNEL_INIT_PRIORITY_DEFAULT, &speed_curve_move_driver_api);
+
+DT_INST_FOREACH_STATUS_OKAY(SPEED_CURVE_MOVE_INST)
@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <errno.h>
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/init.h>
+#include <zephyr/logging/log.h>
+
+#include <zmk/input_processors/speed_curve.h>
+
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#define ZIP_CURVE_DEFINE(node_id)                                                       \
+    BUILD_ASSERT(DT_PROP_LEN(node_id, curve_points) >= 4 &&                            \
+                     DT_PROP_LEN(node_id, curve_points) % 2 == 0,                      \
+                 "curve-points must hold at least two <x value> pairs");                \
+    static const int32_t _CONCAT(zip_curve_points_, DT_DEP_ORD(node_id))[] =          \
+        DT_PROP(node_id, curve_points);                                                \
+    const struct zip_curve ZIP_CURVE_DT_NAME(node_id) = {                              \
+        .profile =                                                                      \
+            {                                                                           \
+                .curve_points = _CONCAT(zip_curve_points_, DT_DEP_ORD(node_id)),       \
+                .curve_points_len = DT_PROP_LEN(node_id, curve_points),                \
+                .interpolation = DT_ENUM_IDX(node_id, interpolation),                  \
+            },                                                                          \
+    };
+
+DT_FOREACH_STATUS_OKAY(zmk_curve, ZIP_CURVE_DEFINE)
+
+#define ZIP_CURVE_CHECK(node_id)                                                        \
+    if (!zip_speed_curve_profile_valid(&ZIP_CURVE_DT_GET(node_id)->profile)) {         \
+        LOG_ERR("%s: curve-points must be sorted by x, with x >= 0 and values between 0 " \
+                "and %d",                                                              \
+                DT_NODE_FULL_NAME(node_id), ZIP_SPEED_CURVE_MAX_SPEED);                \
+        ret = -EINVAL;                                                                 \
+    }
+
+/**
+ * @brief Check every zmk,curve node once at boot
+ *
+ * Devicetree cannot express the ordering rules of curve-points, so a broken
+ * curve is reported here instead of misbehaving when it is first evaluated.
+ */
+static int zip_curve_init(void) {
+    int ret = 0;
+
+    DT_FOREACH_STATUS_OKAY(zmk_curve, ZIP_CURVE_CHECK)
+    __ASSERT(ret == 0, "invalid zmk,curve node");
+
+    return ret;
+}
+
+SYS_INIT(zip_curve_init, PRE_KERNEL_1, CONFIG_KERNEL_INIT_PRIORITY_DEFAULT);
@@ -4,236 +4,1357 @@
  * SPDX-License-Identifier: MIT
  */
 
-#define DT_DRV_COMPAT zmk_input_processor_speed_curve
-
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
 #include <zephyr/kernel.h>
 #include <zephyr/device.h>
+#include <zephyr/dt-bindings/input/input-event-codes.h>
 #include <drivers/input_processor.h>
 #include <zephyr/logging/log.h>
 
+#include <dt-bindings/zmk/speed_curve.h>
 #include <zmk/input_processors/speed_curve.h>
 
+#if IS_ENABLED(CONFIG_ZMK_INPUT_PROCESSOR_SPEED_CURVE_BLOB)
+#include <zephyr/sys/crc.h>
+#endif
+
+#if IS_ENABLED(CONFIG_ZMK_INPUT_PROCESSOR_SPEED_CURVE_TRACE) && IS_ENABLED(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif
+
+#if IS_ENABLED(CONFIG_ZMK_INPUT_PROCESSOR_SPEED_CURVE_COALESCE)
+#include <zmk/endpoints.h>
+#include <zmk/event_manager.h>
+#include <zmk/events/endpoint_changed.h>
+#if IS_ENABLED(CONFIG_ZMK_BLE)
+#include <zephyr/bluetooth/conn.h>
+#include <zmk/ble.h>
+#endif
+#endif
+
 LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 
 /**
- * @brief Check if a given code is in the processor's code array
+ * @brief Find the index of a given code in the processor's code array
+ *
+ * @return Index into cfg->codes (and data->axes), or -1 if the code is not handled
  */
-static bool code_matches(const struct zip_speed_curve_config *cfg, uint16_t code) {
+static int code_index(const struct zip_speed_curve_config *cfg, uint16_t code) {
     for (size_t i = 0; i < cfg->codes_len; i++) {
         if (cfg->codes[i] == code) {
-            return true;
+            return i;
         }
     }
-    return false;
+    return -1;
 }
 
 /**
- * @brief Track remainder for sub-pixel movements
- * Similar to ZMK's track_remainder function
+ * @brief Emit an axis' pending movement, as much as the report can hold
+ *
+ * Instead of letting movement beyond max-output be clipped downstream, it
+ * stays pending and goes out with the following events, even after the
+ * movement stopped. The carry is capped at INT16_MAX px, so a curve that
+ * keeps outrunning the report cannot overflow it.
+ *
+ * @param movement Whole-pixel movement to add to the pending movement
+ * @param release Whether this event may carry movement (false holds it all back)
+ * @return Value to emit
  */
-static void track_remainder(float *move, float *remainder) {
-    float new_move = *move + *remainder;
-    *remainder = new_move - (int)new_move;
-    *move = (int)new_move;
+static int32_t emit_pending(const struct zip_speed_curve_config *cfg,
+                            struct zip_speed_curve_axis *axis, int64_t movement, bool release) {
+    int64_t total = axis->pending + movement;
+    int32_t value = release ? CLAMP(total, -cfg->max_output, cfg->max_output) : 0;
+
+    axis->pending = CLAMP(total - value, -INT16_MAX, INT16_MAX);
+    return value;
 }
 
 /**
- * @brief Calculate speed at given elapsed time using piecewise linear interpolation
- * 
- * @param cfg Configuration containing curve points
- * @param elapsed_ms Elapsed time in milliseconds
- * @return Speed in pixels per second
+ * @brief Emit what is left of an axis' previous movement before a new one starts
+ *
+ * Coalesced movement not yet released, movement carried past max-output and
+ * taken-back prediction lead belong to the movement that ended. They go out
+ * on their own, max-output per event, and the new movement starts with the
+ * first event after them instead of being netted against them.
+ *
+ * @return true if the event carries leftover movement
  */
-static int32_t calculate_speed(const struct zip_speed_curve_config *cfg, int64_t elapsed_ms) {
-    // Curve points are stored as [time0, speed0, time1, speed1, ...]
-    size_t num_points = cfg->curve_points_len / 2;
-    
-    if (num_points == 0) {
+static bool flush_previous(const struct zip_speed_curve_config *cfg,
+                           struct zip_speed_curve_axis *axis, struct input_event *event) {
+    if (axis->pending == 0) {
+        return false;
+    }
+
+    event->value = emit_pending(cfg, axis, 0, true);
+    axis->last_direction = 0;
+    return true;
+}
+
+#if IS_ENABLED(CONFIG_ZMK_INPUT_PROCESSOR_SPEED_CURVE_COALESCE)
+
+// Report interval of the active endpoint in ms, -1 while it needs to be looked up
+static int32_t report_interval_ms = -1;
+
+/**
+ * @brief Look up the interval at which the active endpoint delivers reports
+ *
+ * @return Interval in ms, 0 if reports are not limited by the transport, or -1
+ *         if it cannot be determined yet (e.g. BLE profile not connected)
+ */
+static int32_t lookup_report_interval(void) {
+    struct zmk_endpoint_instance endpoint = zmk_endpoints_selected();
+
+    switch (endpoint.transport) {
+#if IS_ENABLED(CONFIG_ZMK_BLE)
+    case ZMK_TRANSPORT_BLE: {
+        struct bt_conn *conn = bt_conn_lookup_addr_le(BT_ID_DEFAULT, zmk_ble_active_profile_addr());
+        if (conn == NULL) {
+            return -1;
+        }
+
+        struct bt_conn_info info;
+        int err = bt_conn_get_info(conn, &info);
+        bt_conn_unref(conn);
+        if (err) {
+            return -1;
+        }
+
+        // Connection interval is given in units of 1.25 ms
+        return info.le.interval * 5 / 4;
+    }
+#endif
+    default:
+        // USB is polled faster than any sensible trigger period
         return 0;
     }
-    
-    // If before first point, use first point's speed
-    int32_t first_time = cfg->curve_points[0];
-    int32_t first_speed = cfg->curve_points[1];
-    
-    if (elapsed_ms <= first_time) {
-        return first_speed;
+}
+
+static int speed_curve_endpoint_listener(const zmk_event_t *eh) {
+    // Looked up again on the next movement, once the new endpoint is usable
+    report_interval_ms = -1;
+    return ZMK_EV_EVENT_BUBBLE;
+}
+
+ZMK_LISTENER(zip_speed_curve, speed_curve_endpoint_listener);
+ZMK_SUBSCRIPTION(zip_speed_curve, zmk_endpoint_changed);
+
+#if IS_ENABLED(CONFIG_ZMK_BLE)
+static void speed_curve_le_param_updated(struct bt_conn *conn, uint16_t interval,
+                                         uint16_t latency, uint16_t timeout) {
+    // The central may change the interval at any time after connecting
+    report_interval_ms = -1;
+}
+
+BT_CONN_CB_DEFINE(zip_speed_curve_conn_callbacks) = {
+    .le_param_updated = speed_curve_le_param_updated,
+};
+#endif
+
+#endif // IS_ENABLED(CONFIG_ZMK_INPUT_PROCESSOR_SPEED_CURVE_COALESCE)
+
+/**
+ * @brief Decide whether the frame starting now releases the coalesced movement
+ *
+ * Movement is released at most once per report interval of the active
+ * endpoint; frames in between only accumulate into the per-axis pending value.
+ */
+static void start_coalesced_frame(struct zip_speed_curve_data *data, int64_t current_time) {
+    int32_t interval_ms = 0;
+
+#if IS_ENABLED(CONFIG_ZMK_INPUT_PROCESSOR_SPEED_CURVE_COALESCE)
+    if (report_interval_ms < 0) {
+        report_interval_ms = lookup_report_interval();
     }
-    
-    // If after last point, use last point's speed
-    int32_t last_time = cfg->curve_points[(num_points - 1) * 2];
-    int32_t last_speed = cfg->curve_points[(num_points - 1) * 2 + 1];
-    
-    if (elapsed_ms >= last_time) {
-        return last_speed;
+    interval_ms = report_interval_ms;
+#endif
+
+    data->release_frame = (current_time - data->last_release_time) >= interval_ms;
+    if (data->release_frame) {
+        data->last_release_time = current_time;
     }
-    
-    // Find the two points to interpolate between
-    for (size_t i = 0; i < num_points - 1; i++) {
-        int32_t t0 = cfg->curve_points[i * 2];
-        int32_t s0 = cfg->curve_points[i * 2 + 1];
-        int32_t t1 = cfg->curve_points[(i + 1) * 2];
-        int32_t s1 = cfg->curve_points[(i + 1) * 2 + 1];
-        
-        if (elapsed_ms >= t0 && elapsed_ms <= t1) {
-            // Linear interpolation: speed = s0 + (s1 - s0) * (t - t0) / (t1 - t0)
-            int64_t time_delta = t1 - t0;
-            int64_t speed_delta = s1 - s0;
-            int64_t elapsed_in_segment = elapsed_ms - t0;
-            
-            int32_t speed = s0 + (speed_delta * elapsed_in_segment) / time_delta;
-            return speed;
+}
+
+/**
+ * @brief Decide whether a processed event is forwarded or dropped
+ *
+ * With suppress-zero-events enabled, an event with value 0 is dropped unless it
+ * carries the sync of a frame in which an earlier event was already forwarded,
+ * in which case it is kept so the report for that frame still goes out.
+ */
+static int finish_event(const struct zip_speed_curve_config *cfg,
+                        struct zip_speed_curve_data *data,
+                        const struct input_event *event) {
+    if (event->sync) {
+        data->frame_seq++;
+    }
+
+    if (!cfg->suppress_zero_events) {
+        return 0;
+    }
+
+    data->in_frame = !event->sync;
+
+    if (event->value == 0 && (!event->sync || !data->frame_pending)) {
+        return ZMK_INPUT_PROC_STOP;
+    }
+
+    data->frame_pending = !event->sync;
+    return 0;
+}
+
+/**
+ * @brief Forget the progress of the current movement on an axis
+ */
+static void reset_axis(struct zip_speed_curve_axis *axis) {
+    axis->started = false;
+    axis->frames = 0;
+    axis->remainder = 0;
+    axis->filter_primed = false;
+    axis->reversal_count = 0;
+}
+
+/**
+ * @brief Forget the travelled distance after a pause longer than distance-reset-ms
+ *
+ * Shorter pauses keep the distance, so acceleration picks up where it left off.
+ */
+static void check_distance_reset(const struct zip_speed_curve_config *cfg,
+                                 struct zip_speed_curve_data *data,
+                                 struct zip_speed_curve_axis *axis, int64_t current_time) {
+    if (cfg->curve_input == ZIP_SPEED_CURVE_INPUT_DISTANCE_VECTOR) {
+        if (data->last_event_time != 0 &&
+            (current_time - data->last_event_time) > cfg->distance_reset_ms) {
+            data->distance = 0;
         }
+        data->last_event_time = current_time;
+    } else if (axis->last_event_time != 0 &&
+               (current_time - axis->last_event_time) > cfg->distance_reset_ms) {
+        axis->distance = 0;
     }
-    
-    // Should never reach here, but return last speed as fallback
-    return last_speed;
 }
 
 /**
- * @brief Process input event and apply custom speed curve
+ * @brief Add emitted movement to the travelled distance
+ *
+ * For distance-vector input, the movement of all axes within a frame is
+ * combined into one vector and its magnitude is added when the frame ends.
+ *
+ * @param movement Movement of this event with ZIP_SPEED_CURVE_FRAC_BITS fraction bits
  */
-static int zip_speed_curve_handle_event(const struct device *dev,
-                                         struct input_event *event,
-                                         uint32_t param1, uint32_t param2,
-                                         struct zmk_input_processor_state *state) {
+static void track_distance(const struct zip_speed_curve_config *cfg,
+                           struct zip_speed_curve_data *data,
+                           struct zip_speed_curve_axis *axis, int64_t movement, bool sync) {
+    if (cfg->curve_input == ZIP_SPEED_CURVE_INPUT_DISTANCE) {
+        axis->distance += movement;
+        return;
+    }
+
+    // Squares are summed with 8 fraction bits to keep them in 64 bits
+    int64_t component = movement >> (ZIP_SPEED_CURVE_FRAC_BITS - 8);
+    data->frame_distance_sq += component * component;
+
+    if (sync) {
+        data->distance += (int64_t)zip_speed_curve_isqrt64(data->frame_distance_sq)
+                          << (ZIP_SPEED_CURVE_FRAC_BITS - 8);
+        data->frame_distance_sq = 0;
+    }
+}
+
+/**
+ * @brief Check whether a grouped code still contributes to its group's vector
+ *
+ * A code counts while its last value is non-zero, was reported in this or
+ * the previous frame and has not timed out; sources that stop reporting an
+ * axis without a zero value drop out after one frame.
+ */
+static bool group_member_live(const struct zip_speed_curve_config *cfg,
+                              const struct zip_speed_curve_data *data,
+                              const struct zip_speed_curve_axis *axis, int64_t current_time) {
+    if (axis->group_value == 0 || data->frame_seq - axis->group_frame > 1) {
+        return false;
+    }
+
+    return cfg->curve_input == ZIP_SPEED_CURVE_INPUT_FRAMES ||
+           current_time - axis->last_event_time <= ZIP_SPEED_CURVE_TIMEOUT_MS;
+}
+
+/**
+ * @brief Add a grouped code's value to its group
+ *
+ * The group's clock starts over when none of its codes was moving before
+ * this event.
+ *
+ * @return Magnitude of the group's current vector, in 1/256 input units
+ */
+static int64_t update_group(const struct zip_speed_curve_config *cfg,
+                            struct zip_speed_curve_data *data,
+                            struct zip_speed_curve_group *group, int index, int32_t value,
+                            int64_t current_time) {
+    struct zip_speed_curve_axis *axis = &data->axes[index];
+    bool moving = axis->group_value != 0 && data->frame_seq - axis->group_frame <= 1;
+    uint64_t magnitude_sq = 0;
+    // Values are squared two at a time, starting with this event's own
+    int32_t paired = value;
+    bool has_paired = true;
+
+    // Only the other codes of the group, around its ring
+    for (size_t i = cfg->group_next[index]; i != (size_t)index; i = cfg->group_next[i]) {
+        if (!group_member_live(cfg, data, &data->axes[i], current_time)) {
+            continue;
+        }
+        moving = true;
+        if (!has_paired) {
+            paired = data->axes[i].group_value;
+            has_paired = true;
+            continue;
+        }
+        uint64_t square = zip_speed_curve_norm_sq2(paired, data->axes[i].group_value);
+        if (__builtin_add_overflow(magnitude_sq, square, &magnitude_sq)) {
+            magnitude_sq = UINT64_MAX;
+        }
+        has_paired = false;
+    }
+    if (has_paired && __builtin_add_overflow(magnitude_sq, zip_speed_curve_norm_sq2(paired, 0),
+                                             &magnitude_sq)) {
+        magnitude_sq = UINT64_MAX;
+    }
+
+    if (!moving) {
+        group->started = false;
+    }
+    axis->group_value = value;
+    axis->group_frame = data->frame_seq;
+
+    // Keep 8 fractional bits so small diagonal reports are not rounded down
+    if (magnitude_sq < (UINT64_C(1) << 47)) {
+        return MAX(zip_speed_curve_isqrt64(magnitude_sq << 16), 1);
+    }
+    return (int64_t)zip_speed_curve_isqrt64(magnitude_sq) << 8;
+}
+
+/**
+ * @brief Position of an axis group on the curve, shared by all its codes
+ *
+ * @return Elapsed ms since the group started moving, counted in frames for
+ *         frames input
+ */
+static int64_t group_position(const struct zip_speed_curve_config *cfg,
+                              const struct zip_speed_curve_data *data,
+                              struct zip_speed_curve_group *group, int64_t current_time) {
+    if (!group->started) {
+        group->started = true;
+        group->start_time = current_time;
+        group->frames = 0;
+        group->frame = data->frame_seq;
+    }
+
+    if (cfg->curve_input == ZIP_SPEED_CURVE_INPUT_TIME) {
+        return current_time - group->start_time;
+    }
+
+    // Advances once per frame, whichever code of the group comes first
+    if (group->frame != data->frame_seq) {
+        group->frame = data->frame_seq;
+        if (group->frames < UINT32_MAX) {
+            group->frames++;
+        }
+    }
+    return (int64_t)group->frames * cfg->trigger_period_ms;
+}
+
+/**
+ * @brief Evaluate the curve for an axis group
+ *
+ * All codes of a group sit at the same point of the curve within a frame, so
+ * the first code evaluates it and the others reuse its speeds.
+ */
+static void group_speeds(const struct zip_speed_curve_config *cfg,
+                         const struct zip_speed_curve_data *data,
+                         struct zip_speed_curve_group *group,
+                         const struct zip_speed_curve_profile *profile, int64_t position) {
+    if (group->profile == profile && group->eval_frame == data->frame_seq &&
+        group->position == position) {
+        return;
+    }
+
+    group->profile = profile;
+    group->eval_frame = data->frame_seq;
+    group->position = position;
+    group->speed = zip_speed_curve_eval(profile, position);
+    group->predicted_speed =
+        cfg->prediction_ms != 0 ? zip_speed_curve_eval(profile, position + cfg->prediction_ms)
+                                : 0;
+}
+
+/**
+ * @brief Remember how far along the curve an axis was when its movement ended
+ *
+ * @param end_time Uptime of the last event of the movement
+ */
+static void save_momentum(const struct zip_speed_curve_config *cfg,
+                          struct zip_speed_curve_axis *axis, int64_t end_time) {
+    int64_t elapsed_ms;
+
+    switch (cfg->curve_input) {
+    case ZIP_SPEED_CURVE_INPUT_TIME:
+        elapsed_ms = axis->started ? end_time - axis->start_time : 0;
+        break;
+    case ZIP_SPEED_CURVE_INPUT_FRAMES:
+        elapsed_ms = (int64_t)axis->frames * cfg->trigger_period_ms;
+        break;
+    default:
+        // Distance input has its own reset policy (distance-reset-ms)
+        return;
+    }
+
+    axis->resume_elapsed = CLAMP(elapsed_ms, 0, UINT32_MAX) * cfg->resume_retain_percent / 100;
+    axis->resume_until = end_time + cfg->resume_window_ms;
+    axis->resume_direction = axis->last_direction;
+}
+
+/**
+ * @brief Pick up the saved momentum when a movement restarts in time
+ *
+ * @return Elapsed ms the new movement starts at, 0 if there is nothing to resume
+ */
+static uint32_t resume_momentum(struct zip_speed_curve_axis *axis, int8_t direction,
+                                int64_t current_time) {
+    bool resume = axis->resume_direction == direction && current_time <= axis->resume_until;
+
+    axis->resume_direction = 0;
+    if (!resume) {
+        return 0;
+    }
+
+    LOG_DBG("Resuming movement at %u ms", axis->resume_elapsed);
+    return axis->resume_elapsed;
+}
+
+/**
+ * @brief Check whether an opposite-sign value is a real reversal
+ *
+ * A reversal counts once reversal-frames opposite events arrived in a row,
+ * or right away if the value reaches reversal-threshold.
+ */
+static bool reversal_confirmed(const struct zip_speed_curve_config *cfg,
+                               struct zip_speed_curve_axis *axis, int32_t value) {
+    if (cfg->reversal_threshold != 0 && abs(value) >= cfg->reversal_threshold) {
+        return true;
+    }
+
+    return ++axis->reversal_count >= cfg->reversal_frames;
+}
+
+/**
+ * @brief Handle touch-down and lift of an absolute (touch) source
+ *
+ * Every touch starts from a new origin; a lift also ends the movement.
+ */
+static void handle_touch(const struct zip_speed_curve_config *cfg,
+                         struct zip_speed_curve_data *data, bool touching) {
+    for (size_t i = 0; i < cfg->codes_len; i++) {
+        struct zip_speed_curve_axis *axis = &data->axes[i];
+
+        axis->has_position = false;
+        if (!touching) {
+            reset_axis(axis);
+            axis->last_direction = 0;
+            axis->last_event_time = 0;
+            axis->distance = 0;
+        }
+    }
+}
+
+/**
+ * @brief Smooth the measured input speed before the curve lookup
+ *
+ * "ema" is a low-pass filter at filter-min-cutoff-mhz. "one-euro" raises the
+ * cutoff with the (itself low-passed) rate of change of the speed, so noise at
+ * rest is smoothed heavily while fast changes pass with little lag.
+ * Everything is integer math on per-axis state; the filtered value is
+ * available for the same event, so no frame of latency is added.
+ *
+ * @param velocity Measured input speed in px/s
+ * @param interval_us Time since the previous event in us
+ * @return Filtered input speed in px/s
+ */
+static int32_t filter_velocity(const struct zip_speed_curve_config *cfg,
+                               struct zip_speed_curve_axis *axis, int64_t velocity,
+                               int64_t interval_us) {
+    if (!axis->filter_primed) {
+        axis->filtered_velocity = velocity;
+        axis->filtered_accel = 0;
+        axis->filter_primed = true;
+        return velocity;
+    }
+
+    int64_t cutoff_mhz = cfg->filter_min_cutoff_mhz;
+
+    if (cfg->velocity_filter == ZIP_SPEED_CURVE_FILTER_ONE_EURO) {
+        // Rate of change in px/s^2; beta is given in mHz per px/s^2
+        int64_t accel = CLAMP((velocity - axis->filtered_velocity) * 1000000 / interval_us,
+                              -INT32_MAX, INT32_MAX);
+        int64_t accel_alpha =
+            zip_speed_curve_lowpass_alpha(cfg->filter_d_cutoff_mhz, interval_us);
+        axis->filtered_accel +=
+            ((accel - axis->filtered_accel) * accel_alpha) >> ZIP_SPEED_CURVE_FRAC_BITS;
+        cutoff_mhz += zip_speed_curve_mul_sat(cfg->filter_beta, abs(axis->filtered_accel));
+    }
+
+    int64_t alpha = zip_speed_curve_lowpass_alpha(cutoff_mhz, interval_us);
+    axis->filtered_velocity +=
+        ((velocity - axis->filtered_velocity) * alpha) >> ZIP_SPEED_CURVE_FRAC_BITS;
+
+    return axis->filtered_velocity;
+}
+
+/**
+ * @brief Convert speed (px/sec) to fixed-point movement (px/event)
+ *
+ * movement = speed * trigger_period_ms / 1000 * scale-multiplier / scale-divisor * gain,
+ * with everything but the per-reference gain folded into movement_scale at
+ * build time (for hi-res-scroll, notches/sec to hi-res units/event).
+ */
+static int64_t speed_to_movement(const struct zip_speed_curve_config *cfg, int32_t speed,
+                                 uint32_t gain) {
+    int64_t movement = zip_speed_curve_mul_sat(speed, cfg->movement_scale);
+
+    return zip_speed_curve_apply_gain(movement >> (32 - ZIP_SPEED_CURVE_FRAC_BITS), gain);
+}
+
+/**
+ * @brief Take back the distance prediction emitted ahead of the curve
+ *
+ * @return Whole-pixel correction, signed for the axis' last direction
+ */
+static int32_t take_prediction_lead(struct zip_speed_curve_axis *axis) {
+    int32_t lead_px = (axis->lead + (1 << (ZIP_SPEED_CURVE_FRAC_BITS - 1))) >>
+                      ZIP_SPEED_CURVE_FRAC_BITS;
+
+    axis->lead = 0;
+    return -axis->last_direction * lead_px;
+}
+
+/**
+ * @brief Select the curve for a listener reference
+ *
+ * A profile index without a child node falls back to profile 0, with a
+ * warning the first time.
+ *
+ * @param profile_index Profile cell of the reference: 0 for the node's own
+ *                      curve (or the curve blob replacing it), n for its n-th
+ *                      child node
+ */
+static const struct zip_speed_curve_profile *
+select_profile(const struct zip_speed_curve_config *cfg, struct zip_speed_curve_data *data,
+               uint32_t profile_index) {
+    if (profile_index >= cfg->profiles_len && !data->profile_warned) {
+        data->profile_warned = true;
+        LOG_WRN("Speed curve profile %u does not exist (%zu profiles), using profile 0",
+                profile_index, cfg->profiles_len);
+    }
+
+    if (profile_index == 0 || profile_index >= cfg->profiles_len) {
+        return data->blob_profile.curve_points != NULL ? &data->blob_profile : &cfg->profiles[0];
+    }
+    return &cfg->profiles[profile_index];
+}
+
+#if IS_ENABLED(CONFIG_ZMK_INPUT_PROCESSOR_SPEED_CURVE_BLOB)
+/**
+ * @brief Validate a curve blob and point a profile into it
+ *
+ * The blob is used in place through its memory-mapped flash address, so
+ * nothing is copied to RAM.
+ *
+ * @return 0 on success, -EINVAL if the blob is missing or invalid
+ */
+static int load_curve_blob(const void *blob, size_t blob_size,
+                           struct zip_speed_curve_profile *profile) {
+    const struct zip_speed_curve_blob_header *hdr = blob;
+
+    if (blob_size < sizeof(*hdr) || hdr->magic != ZIP_SPEED_CURVE_BLOB_MAGIC) {
+        return -EINVAL;
+    }
+
+    if (hdr->version != ZIP_SPEED_CURVE_BLOB_VERSION || hdr->num_points < 2 ||
+        hdr->num_points > CONFIG_ZMK_INPUT_PROCESSOR_SPEED_CURVE_MAX_POINTS ||
+        ZIP_SPEED_CURVE_SEARCH_DEPTH(hdr->num_points) >
+            CONFIG_ZMK_INPUT_PROCESSOR_SPEED_CURVE_MAX_SEARCH_DEPTH ||
+        hdr->interpolation > ZIP_SPEED_CURVE_INTERP_STEP ||
+        (hdr->lut_shift & ~ZIP_SPEED_CURVE_BLOB_LUT_LOG) >= ZIP_SPEED_CURVE_FRAC_BITS) {
+        LOG_WRN("Unsupported curve blob (version %d)", hdr->version);
+        return -EINVAL;
+    }
+
+    size_t num_words = hdr->num_points * 2 + (hdr->num_points - 1) + hdr->lut_len;
+    if (hdr->payload_len != num_words * sizeof(int32_t) ||
+        hdr->payload_len > blob_size - sizeof(*hdr)) {
+        LOG_WRN("Curve blob size mismatch");
+        return -EINVAL;
+    }
+
+    const int32_t *payload = (const int32_t *)(hdr + 1);
+    if (crc32_ieee((const uint8_t *)payload, hdr->payload_len) != hdr->crc) {
+        LOG_WRN("Curve blob CRC mismatch");
+        return -EINVAL;
+    }
+
+    profile->curve_points = payload;
+    profile->curve_points_len = hdr->num_points * 2;
+    profile->slopes = payload + hdr->num_points * 2;
+    profile->lut = hdr->lut_len > 0 ? profile->slopes + (hdr->num_points - 1) : NULL;
+    profile->lut_len = hdr->lut_len;
+    profile->lut_shift = hdr->lut_shift & ~ZIP_SPEED_CURVE_BLOB_LUT_LOG;
+    profile->lut_log = (hdr->lut_shift & ZIP_SPEED_CURVE_BLOB_LUT_LOG) != 0;
+    profile->interpolation = hdr->interpolation;
+
+    if (!zip_speed_curve_profile_valid(profile)) {
+        LOG_WRN("Curve blob points are unsorted or out of range");
+        return -EINVAL;
+    }
+
+    return 0;
+}
+#endif
+
+/**
+ * @brief Apply the speed curve to an input event
+ *
+ * param1 is an optional gain built with ZIP_SPEED_CURVE_GAIN() (0 = unity),
+ * param2 an optional profile index (see select_profile()).
+ */
+static int process_event(const struct device *dev, struct input_event *event, uint32_t param1,
+                         uint32_t param2) {
     const struct zip_speed_curve_config *cfg = dev->config;
     struct zip_speed_curve_data *data = dev->data;
 
     // Only process matching event types and codes
-    if (event->type != cfg->type || !code_matches(cfg, event->code)) {
+    int index = event->type == cfg->type ? code_index(cfg, event->code) : -1;
+    if (index < 0) {
+        if (cfg->type == INPUT_EV_ABS && event->type == INPUT_EV_KEY &&
+            event->code == INPUT_BTN_TOUCH) {
+            handle_touch(cfg, data, event->value != 0);
+        }
+
+        // Other events are forwarded untouched but still shape the current frame
+        if (event->sync) {
+            data->frame_seq++;
+        }
+        if (cfg->suppress_zero_events) {
+            data->frame_pending = !event->sync;
+            data->in_frame = !event->sync;
+        }
         return 0;
     }
 
-    int32_t value = event->value;
-    
-    // Determine if this is X or Y axis (assuming INPUT_REL_X and INPUT_REL_Y)
-    bool is_x_axis = (event->code == 0);  // INPUT_REL_X = 0, INPUT_REL_Y = 1
-    int8_t *last_direction = is_x_axis ? &data->last_x_direction : &data->last_y_direction;
-    int64_t *axis_start_time = is_x_axis ? &data->x_start_time : &data->y_start_time;
-    int64_t *axis_last_event_time = is_x_axis ? &data->x_last_event_time : &data->y_last_event_time;
-    
-    // Determine current direction
-    int8_t current_direction = (value > 0) ? 1 : (value < 0) ? -1 : 0;
+    struct zip_speed_curve_axis *axis = &data->axes[index];
     
     // Check if movement has timed out (no events for a while = user released key)
-    int64_t current_time = k_uptime_get();
-    if (*axis_last_event_time != 0 && 
-        (current_time - *axis_last_event_time) > ZIP_SPEED_CURVE_TIMEOUT_MS) {
-        // Movement timed out, reset timing
-        *axis_start_time = 0;
-        if (is_x_axis) {
-            data->x_remainder = 0.0f;
-        } else {
-            data->y_remainder = 0.0f;
+    int64_t current_time = 0;
+    int64_t idle_ms = 0;
+    uint32_t interval_us = 0;
+    bool timed_out = false;
+    if (cfg->curve_input == ZIP_SPEED_CURVE_INPUT_FRAMES) {
+        // The momentum resume window is the only reason to read the uptime here
+        if (cfg->resume_window_ms != 0) {
+            current_time = k_uptime_get();
         }
+#if IS_ENABLED(CONFIG_ZMK_INPUT_PROCESSOR_SPEED_CURVE_FRAME_TIMEOUT)
+        // Only the raw cycle counter is read; elapsed time comes from the frame count
+        uint32_t current_cycles = k_cycle_get_32();
+        uint32_t idle_cycles = current_cycles - axis->last_event_cycles;
+        timed_out = axis->frames != 0 &&
+                    idle_cycles > k_ms_to_cyc_ceil32(ZIP_SPEED_CURVE_TIMEOUT_MS);
+        if (timed_out) {
+            idle_ms = k_cyc_to_ms_floor32(idle_cycles);
+        }
+        axis->last_event_cycles = current_cycles;
+#endif
+    } else {
+        current_time = k_uptime_get();
+        idle_ms = current_time - axis->last_event_time;
+        timed_out = axis->last_event_time != 0 && idle_ms > ZIP_SPEED_CURVE_TIMEOUT_MS;
+        if (cfg->curve_input >= ZIP_SPEED_CURVE_INPUT_DISTANCE) {
+            check_distance_reset(cfg, data, axis, current_time);
+        }
+        if (cfg->curve_input == ZIP_SPEED_CURVE_INPUT_VELOCITY) {
+            // Uptime has 1 ms resolution, too coarse for sensors that report every
+            // millisecond or faster; the cycle counter gives the interval in us
+            uint32_t current_cycles = k_cycle_get_32();
+            if (axis->last_event_time != 0 && !timed_out) {
+                interval_us = k_cyc_to_us_floor32(current_cycles - axis->last_event_cycles);
+            }
+            axis->last_event_cycles = current_cycles;
+        }
+        // Update last event time
+        axis->last_event_time = current_time;
+    }
+
+    if (timed_out) {
+        // Movement ended with the previous event; keep its momentum for a quick re-press
+        if (cfg->resume_window_ms != 0) {
+            save_momentum(cfg, axis, current_time - idle_ms);
+        }
+        // Movement timed out, reset timing. The prediction lead is taken back and, with
+        // coalesced movement still held back, goes out before the new movement
+        // (flush_previous())
+        axis->pending += take_prediction_lead(axis);
+        reset_axis(axis);
+        // A new movement after the pause may go either way, it is not a reversal
+        axis->last_direction = 0;
+        axis->has_position = false;
+        axis->group_value = 0;
         LOG_DBG("Movement timeout detected, resetting acceleration");
     }
-    
-    // Update last event time
-    *axis_last_event_time = current_time;
+
+    if (cfg->type == INPUT_EV_ABS) {
+        // Absolute position to relative movement; the first report of a touch
+        // only sets the origin. ABS and REL codes share their numbers.
+        int32_t position = event->value;
+        event->value = axis->has_position
+                           ? CLAMP((int64_t)position - axis->last_position, -INT32_MAX, INT32_MAX)
+                           : 0;
+        event->type = INPUT_EV_REL;
+        axis->last_position = position;
+        axis->has_position = true;
+    }
+
+    // -INT32_MIN does not exist, everything below relies on abs(value) fitting
+    int32_t value = MAX(event->value, -INT32_MAX);
+
+    // Determine current direction
+    int8_t current_direction = (value > 0) ? 1 : (value < 0) ? -1 : 0;
+
+    // Magnitude of the code's axis group, |value| if it is not grouped
+    struct zip_speed_curve_group *group = NULL;
+    int64_t magnitude = (int64_t)abs(value) << 8;
+    int64_t share = 1 << 16;
+    if (cfg->axis_groups != NULL && cfg->curve_input <= ZIP_SPEED_CURVE_INPUT_VELOCITY) {
+        group = &data->groups[cfg->axis_groups[index]];
+        magnitude = update_group(cfg, data, group, index, value, current_time);
+        // Fraction of the group's vector along this code, 16.16
+        share = ((int64_t)abs(value) << 24) / magnitude;
+    }
+
+    if (cfg->coalesce_reports && !data->in_frame) {
+        start_coalesced_frame(data, cfg->curve_input == ZIP_SPEED_CURVE_INPUT_FRAMES
+                                        ? k_uptime_get()
+                                        : current_time);
+    }
     
     // Check if movement stopped (value == 0)
     if (value == 0) {
-        *last_direction = 0;
-        *axis_start_time = 0;
-        *axis_last_event_time = 0;
-        // Clear remainder when movement stops
-        if (is_x_axis) {
-            data->x_remainder = 0.0f;
-        } else {
-            data->y_remainder = 0.0f;
+        if (cfg->resume_window_ms != 0) {
+            save_momentum(cfg, axis, current_time);
         }
+        // Take back what prediction emitted ahead of the curve
+        axis->pending += take_prediction_lead(axis);
+        axis->last_direction = 0;
+        axis->last_event_time = 0;
+        // Clear timing, remainder and travelled distance when movement stops
+        reset_axis(axis);
+        axis->distance = 0;
+        // Flush movement still held back for the next coalesced report
+        event->value = emit_pending(cfg, axis, 0, true);
         LOG_DBG("Movement stopped on axis, resetting timing");
-        return 0;
+        return finish_event(cfg, data, event);
+    }
+
+    // A new movement starts once the previous one is fully emitted
+    if (axis->last_direction == 0 && flush_previous(cfg, axis, event)) {
+        return finish_event(cfg, data, event);
     }
     
-    // Check if direction changed - reset timing for this axis
-    if (*last_direction != 0 && *last_direction != current_direction) {
-        *axis_start_time = 0;
-        // Clear remainder when direction changes
-        if (is_x_axis) {
-            data->x_remainder = 0.0f;
-        } else {
-            data->y_remainder = 0.0f;
+    // Check if direction changed - reset timing and remainder for this axis
+    if (axis->last_direction != 0 && axis->last_direction != current_direction) {
+        if (!reversal_confirmed(cfg, axis, value)) {
+            // Sign flip treated as sensor jitter: swallow it, keep the acceleration
+            event->value = 0;
+            LOG_DBG("Ignoring direction jitter (%d)", value);
+            return finish_event(cfg, data, event);
         }
+        axis->pending += take_prediction_lead(axis);
+        reset_axis(axis);
+        axis->distance = 0;
         LOG_DBG("Direction changed, resetting timing");
+        if (flush_previous(cfg, axis, event)) {
+            return finish_event(cfg, data, event);
+        }
     }
     
-    *last_direction = current_direction;
+    axis->last_direction = current_direction;
+    axis->reversal_count = 0;
     
-    // Start timing if not already started for this axis
-    // Similar to ZMK's set_start_times_for_activity_1d logic
-    if (*axis_start_time == 0) {
-        *axis_start_time = k_uptime_get();
-        LOG_DBG("Movement started at %lld ms", *axis_start_time);
+    // Position on the curve's x-axis: elapsed ms for time/frames input, px for distance input
+    int64_t curve_position;
+    switch (cfg->curve_input) {
+    case ZIP_SPEED_CURVE_INPUT_FRAMES:
+        if (axis->frames == 0 && cfg->resume_window_ms != 0) {
+            axis->frames = resume_momentum(axis, current_direction, current_time) /
+                           cfg->trigger_period_ms;
+        }
+
+        // The n-th frame of a movement always maps to the same point on the curve
+        curve_position = (int64_t)axis->frames * cfg->trigger_period_ms;
+        if (axis->frames < UINT32_MAX) {
+            axis->frames++;
+        }
+        break;
+    case ZIP_SPEED_CURVE_INPUT_VELOCITY: {
+        // Input speed in px/s over the time since the previous event; the first event
+        // of a movement has no previous one and assumes trigger-period-ms
+        int64_t interval = interval_us > 0 ? interval_us : cfg->trigger_period_ms * 1000;
+        curve_position = MIN((magnitude * 1000000 / interval) >> 8, INT32_MAX);
+        if (cfg->velocity_filter != ZIP_SPEED_CURVE_FILTER_NONE) {
+            curve_position = filter_velocity(cfg, axis, curve_position, interval);
+        }
+        break;
+    }
+    case ZIP_SPEED_CURVE_INPUT_DISTANCE:
+        curve_position = axis->distance >> ZIP_SPEED_CURVE_FRAC_BITS;
+        break;
+    case ZIP_SPEED_CURVE_INPUT_DISTANCE_VECTOR:
+        curve_position = data->distance >> ZIP_SPEED_CURVE_FRAC_BITS;
+        break;
+    default:
+        // Start timing if not already started for this axis
+        // Similar to ZMK's set_start_times_for_activity_1d logic
+        if (!axis->started) {
+            axis->start_time = current_time;
+            axis->started = true;
+            if (cfg->resume_window_ms != 0) {
+                axis->start_time -= resume_momentum(axis, current_direction, current_time);
+            }
+            LOG_DBG("Movement started at %lld ms", axis->start_time);
+        }
+
+        // Calculate elapsed time for this specific axis
+        curve_position = current_time - axis->start_time;
+        break;
+    }
+
+    // Calculate speed from the curve selected by this reference
+    const struct zip_speed_curve_profile *profile = select_profile(cfg, data, param2);
+    bool group_curve = group != NULL && cfg->curve_input <= ZIP_SPEED_CURVE_INPUT_FRAMES;
+    int32_t speed_px_per_sec;
+    if (group_curve) {
+        // All codes of the group sit at the same point of the curve
+        curve_position = group_position(cfg, data, group, current_time);
+        group_speeds(cfg, data, group, profile, curve_position);
+        speed_px_per_sec = group->speed;
+    } else {
+        speed_px_per_sec = zip_speed_curve_eval(profile, curve_position);
     }
     
-    // Calculate elapsed time for this specific axis
-    int64_t elapsed_ms = current_time - *axis_start_time;
-    
-    // Calculate speed from curve
-    int32_t speed_px_per_sec = calculate_speed(cfg, elapsed_ms);
-    
-    // Convert speed (px/sec) to movement (px/event) using float math for precision
-    // movement = speed * trigger_period_ms / 1000
-    float movement = (float)speed_px_per_sec * cfg->trigger_period_ms / 1000.0f;
-    
-    // Handle remainder tracking if enabled
-    if (cfg->track_remainders) {
-        float *remainder = is_x_axis ? &data->x_remainder : &data->y_remainder;
-        track_remainder(&movement, remainder);
+    int64_t movement;
+    if (cfg->curve_input == ZIP_SPEED_CURVE_INPUT_VELOCITY) {
+        // Scale the input by output speed over input speed
+        int64_t output = zip_speed_curve_mul_sat((int64_t)abs(value) * speed_px_per_sec,
+                                                 cfg->output_gain);
+        movement = zip_speed_curve_apply_gain(output / MAX(curve_position, 1), param1);
+    } else {
+        movement = speed_to_movement(cfg, speed_px_per_sec, param1);
+        if (group != NULL) {
+            // The curve gives the speed of the group's vector, this code moves its share
+            movement = zip_speed_curve_mul_sat(movement, share) >> 16;
+        }
+    }
+
+    if (cfg->prediction_ms != 0 && cfg->curve_input <= ZIP_SPEED_CURVE_INPUT_FRAMES) {
+        // Emit the movement from prediction-ms further along the curve and keep
+        // track of how far ahead that puts the axis, to take it back on release
+        int32_t predicted_speed =
+            group_curve ? group->predicted_speed
+                        : zip_speed_curve_eval(profile, curve_position + cfg->prediction_ms);
+        int64_t predicted = speed_to_movement(cfg, predicted_speed, param1);
+        if (group != NULL) {
+            predicted = zip_speed_curve_mul_sat(predicted, share) >> 16;
+        }
+        predicted = MIN(predicted, ZIP_SPEED_CURVE_MAX_MOVEMENT);
+        axis->lead = CLAMP(axis->lead + predicted - MIN(movement, ZIP_SPEED_CURVE_MAX_MOVEMENT),
+                           -ZIP_SPEED_CURVE_MAX_MOVEMENT, ZIP_SPEED_CURVE_MAX_MOVEMENT);
+        movement = predicted;
+    }
+
+    // No frame carries more than a report can; also keeps the int32 state below from overflowing
+    movement = MIN(movement, ZIP_SPEED_CURVE_MAX_MOVEMENT);
+
+    if (cfg->curve_input >= ZIP_SPEED_CURVE_INPUT_DISTANCE) {
+        track_distance(cfg, data, axis, movement, event->sync);
     }
     
-    // Apply direction
-    event->value = current_direction * (int32_t)movement;
+    // Whole pixels, carrying the fraction if enabled
+    int64_t pixels =
+        zip_speed_curve_track_remainder(movement, &axis->remainder, cfg->track_remainders);
+
+    // Apply direction, plus any prediction correction left by the previous movement. With
+    // coalesce-reports, movement is held back until the frame that releases the report.
+    event->value = emit_pending(cfg, axis, current_direction * pixels,
+                                !cfg->coalesce_reports || data->release_frame);
     
-    LOG_DBG("Speed curve: elapsed=%lld ms, speed=%d px/s, movement=%d px/event (original=%d)",
-            elapsed_ms, speed_px_per_sec, event->value, value);
+    LOG_DBG("Speed curve: position=%lld, speed=%d px/s, movement=%d px/event (original=%d)",
+            curve_position, speed_px_per_sec, event->value, value);
 
-    return 0;
+    return finish_event(cfg, data, event);
+}
+
+#if IS_ENABLED(CONFIG_ZMK_INPUT_PROCESSOR_SPEED_CURVE_TRACE)
+// Longest encoded record: header byte, delta varint, value varint
+#define TRACE_RECORD_MAX (1 + 10 + 10)
+
+/**
+ * @brief Append an unsigned LEB128 varint
+ *
+ * @return Number of bytes written
+ */
+static size_t put_varint(uint8_t *buf, uint64_t value) {
+    size_t len = 0;
+
+    while (value >= 0x80) {
+        buf[len++] = (value & 0x7F) | 0x80;
+        value >>= 7;
+    }
+    buf[len++] = value;
+    return len;
+}
+
+/**
+ * @brief Map a signed value to an unsigned one with small magnitudes first
+ */
+static uint64_t zigzag(int64_t value) { return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63); }
+
+/**
+ * @brief Capture an incoming event before it is processed
+ *
+ * Records are a header byte (slot << 1 | sync, slot being the code index or
+ * ZIP_SPEED_CURVE_TRACE_SLOT_TOUCH), a varint ms delta to the previous
+ * record and the zigzag varint value delta to the previous value of that
+ * code. When the buffer is full the record is dropped and a
+ * ZIP_SPEED_CURVE_TRACE_RESTART marker, which no header byte can equal,
+ * starts the next successful one over from absolute time and values.
+ */
+static void trace_event(const struct zip_speed_curve_config *cfg,
+                        struct zip_speed_curve_data *data, const struct input_event *event) {
+    struct zip_speed_curve_trace *trace = data->trace;
+    int index = event->type == cfg->type ? code_index(cfg, event->code) : -1;
+    uint8_t slot;
+    int64_t value = event->value;
+
+    if (index >= 0 && index < ZIP_SPEED_CURVE_TRACE_SLOT_TOUCH) {
+        slot = index;
+    } else if (cfg->type == INPUT_EV_ABS && event->type == INPUT_EV_KEY &&
+               event->code == INPUT_BTN_TOUCH) {
+        slot = ZIP_SPEED_CURVE_TRACE_SLOT_TOUCH;
+    } else {
+        return;
+    }
+
+    uint8_t record[1 + TRACE_RECORD_MAX];
+    size_t len = 0;
+    int64_t now = k_uptime_get();
+    k_spinlock_key_t key = k_spin_lock(&trace->lock);
+
+    if (trace->restart) {
+        record[len++] = ZIP_SPEED_CURVE_TRACE_RESTART;
+        trace->last_time = 0;
+        for (size_t i = 0; i < cfg->codes_len; i++) {
+            data->axes[i].trace_value = 0;
+        }
+    }
+
+    record[len++] = (slot << 1) | event->sync;
+    len += put_varint(&record[len], now - trace->last_time);
+    if (slot != ZIP_SPEED_CURVE_TRACE_SLOT_TOUCH) {
+        value -= data->axes[slot].trace_value;
+    }
+    len += put_varint(&record[len], zigzag(value));
+
+    if (ring_buf_space_get(&trace->buf) < len) {
+        trace->dropped++;
+        trace->restart = true;
+    } else {
+        ring_buf_put(&trace->buf, record, len);
+        trace->last_time = now;
+        trace->restart = false;
+        if (slot != ZIP_SPEED_CURVE_TRACE_SLOT_TOUCH) {
+            data->axes[slot].trace_value = event->value;
+        }
+    }
+
+    k_spin_unlock(&trace->lock, key);
+}
+#endif
+
+/**
+ * @brief Process input event and apply custom speed curve
+ */
+static int zip_speed_curve_handle_event(const struct device *dev,
+                                         struct input_event *event,
+                                         uint32_t param1, uint32_t param2,
+                                         struct zmk_input_processor_state *state) {
+#if IS_ENABLED(CONFIG_ZMK_INPUT_PROCESSOR_SPEED_CURVE_TRACE)
+    trace_event(dev->config, dev->data, event);
+#endif
+
+    return process_event(dev, event, param1, param2);
 }
 
 /**
  * @brief Initialize the speed curve input processor
  */
 static int zip_speed_curve_init(const struct device *dev) {
+    const struct zip_speed_curve_config *cfg = dev->config;
     struct zip_speed_curve_data *data = dev->data;
     
-    data->x_start_time = 0;
-    data->y_start_time = 0;
-    data->x_last_event_time = 0;
-    data->y_last_event_time = 0;
-    data->last_x_direction = 0;
-    data->last_y_direction = 0;
-    data->x_remainder = 0.0f;
-    data->y_remainder = 0.0f;
+    memset(data->axes, 0, cfg->codes_len * sizeof(*data->axes));
+    data->last_release_time = 0;
+    data->frame_pending = false;
+    data->in_frame = false;
+    data->release_frame = false;
+    data->last_event_time = 0;
+    data->distance = 0;
+    data->frame_distance_sq = 0;
+    data->blob_profile.curve_points = NULL;
+    data->profile_warned = false;
+    data->frame_seq = 0;
+    if (data->groups != NULL) {
+        memset(data->groups, 0, cfg->codes_len * sizeof(*data->groups));
+    }
+
+#if IS_ENABLED(CONFIG_ZMK_INPUT_PROCESSOR_SPEED_CURVE_TRACE)
+    ring_buf_init(&data->trace->buf, CONFIG_ZMK_INPUT_PROCESSOR_SPEED_CURVE_TRACE_SIZE,
+                  data->trace->storage);
+    data->trace->restart = true;
+#endif
+
+    for (size_t i = 0; i < cfg->profiles_len; i++) {
+        if (!zip_speed_curve_profile_valid(&cfg->profiles[i])) {
+            LOG_ERR("%s: curve %zu must be sorted by time, with times >= 0 and speeds "
+                    "between 0 and %d",
+                    dev->name, i, ZIP_SPEED_CURVE_MAX_SPEED);
+            return -EINVAL;
+        }
+    }
+
+#if IS_ENABLED(CONFIG_ZMK_INPUT_PROCESSOR_SPEED_CURVE_BLOB)
+    if (cfg->blob != NULL) {
+        if (load_curve_blob(cfg->blob, cfg->blob_size, &data->blob_profile) == 0) {
+            LOG_INF("Using curve blob for %s", dev->name);
+        } else {
+            data->blob_profile.curve_points = NULL;
+            LOG_WRN("No valid curve blob for %s, using devicetree curve", dev->name);
+        }
+    }
+#endif
     
     LOG_DBG("Initialized speed curve input processor: %s", dev->name);
     
     return 0;
 }
 
+int zip_speed_curve_reset(const struct device *dev) {
+    const struct zip_speed_curve_config *cfg = dev->config;
+    struct zip_speed_curve_data *data = dev->data;
+
+    for (size_t i = 0; i < cfg->codes_len; i++) {
+        struct zip_speed_curve_axis *axis = &data->axes[i];
+
+        reset_axis(axis);
+        axis->last_direction = 0;
+        axis->last_event_time = 0;
+        axis->pending = 0;
+        axis->distance = 0;
+        axis->resume_direction = 0;
+        axis->lead = 0;
+        axis->group_value = 0;
+    }
+
+    data->last_event_time = 0;
+    data->distance = 0;
+    data->frame_distance_sq = 0;
+
+    return 0;
+}
+
 static const struct zmk_input_processor_driver_api zip_speed_curve_driver_api = {
     .handle_event = zip_speed_curve_handle_event,
 };
 
-#define ZIP_SPEED_CURVE_INST(n)                                                         \
-    static const uint16_t zip_speed_curve_codes_##n[] = DT_INST_PROP(n, codes);       \
-    static const int32_t zip_speed_curve_points_##n[] = DT_INST_PROP(n, curve_points); \
-    static const struct zip_speed_curve_config zip_speed_curve_config_##n = {         \
-        .type = DT_INST_PROP(n, type),                                                 \
-        .codes = zip_speed_curve_codes_##n,                                            \
-        .codes_len = DT_INST_PROP_LEN(n, codes),                                       \
-        .curve_points = zip_speed_curve_points_##n,                                    \
-        .curve_points_len = DT_INST_PROP_LEN(n, curve_points),                         \
-        .trigger_period_ms = DT_INST_PROP(n, trigger_period_ms),                       \
-        .track_remainders = DT_INST_PROP_OR(n, track_remainders, false),               \
+#if IS_ENABLED(CONFIG_ZMK_INPUT_PROCESSOR_SPEED_CURVE_TRACE) && IS_ENABLED(CONFIG_SHELL)
+/**
+ * @brief Look up a speed curve instance by device name for a shell command
+ */
+static const struct device *shell_trace_device(const struct shell *sh, const char *name) {
+    const struct device *dev = device_get_binding(name);
+
+    if (dev == NULL || dev->api != &zip_speed_curve_driver_api) {
+        shell_error(sh, "%s is not a speed curve input processor", name);
+        return NULL;
+    }
+    return dev;
+}
+
+static int cmd_trace_dump(const struct shell *sh, size_t argc, char **argv) {
+    const struct device *dev = shell_trace_device(sh, argv[1]);
+    if (dev == NULL) {
+        return -ENODEV;
+    }
+
+    const struct zip_speed_curve_config *cfg = dev->config;
+    struct zip_speed_curve_trace *trace = ((struct zip_speed_curve_data *)dev->data)->trace;
+
+    // Header for scripts/speed_curve_trace.py: what the slots of the records mean
+    shell_fprintf(sh, SHELL_NORMAL, "trace %s type %d codes", dev->name, cfg->type);
+    for (size_t i = 0; i < cfg->codes_len; i++) {
+        shell_fprintf(sh, SHELL_NORMAL, " %d", cfg->codes[i]);
+    }
+    shell_fprintf(sh, SHELL_NORMAL, "\n");
+
+    // Drain the buffer in chunks, so capture can keep going while exporting
+    uint8_t chunk[32];
+    size_t total = 0;
+    for (;;) {
+        k_spinlock_key_t key = k_spin_lock(&trace->lock);
+        uint32_t len = ring_buf_get(&trace->buf, chunk, sizeof(chunk));
+        k_spin_unlock(&trace->lock, key);
+
+        if (len == 0) {
+            break;
+        }
+        for (uint32_t i = 0; i < len; i++) {
+            shell_fprintf(sh, SHELL_NORMAL, "%02x", chunk[i]);
+        }
+        shell_fprintf(sh, SHELL_NORMAL, "\n");
+        total += len;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&trace->lock);
+    uint32_t dropped = trace->dropped;
+    trace->dropped = 0;
+    k_spin_unlock(&trace->lock, key);
+
+    shell_print(sh, "end %zu bytes, %u records dropped", total, dropped);
+    return 0;
+}
+
+static int cmd_trace_clear(const struct shell *sh, size_t argc, char **argv) {
+    const struct device *dev = shell_trace_device(sh, argv[1]);
+    if (dev == NULL) {
+        return -ENODEV;
+    }
+
+    struct zip_speed_curve_trace *trace = ((struct zip_speed_curve_data *)dev->data)->trace;
+    k_spinlock_key_t key = k_spin_lock(&trace->lock);
+    ring_buf_reset(&trace->buf);
+    trace->dropped = 0;
+    trace->restart = true;
+    k_spin_unlock(&trace->lock, key);
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+    sub_speed_curve_trace,
+    SHELL_CMD_ARG(dump, NULL, "Export and empty the capture: dump <device>", cmd_trace_dump, 2, 0),
+    SHELL_CMD_ARG(clear, NULL, "Discard the capture: clear <device>", cmd_trace_clear, 2, 0),
+    SHELL_SUBCMD_SET_END);
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_speed_curve,
+                               SHELL_CMD(trace, &sub_speed_curve_trace, "Input capture", NULL),
+                               SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(speed_curve, &sub_speed_curve, "Speed curve input processor", NULL);
+#endif
+
+#define ZIP_SPEED_CURVE_NAME(prefix, node_id) _CONCAT(prefix, DT_DEP_ORD(node_id))
+
+#define ZIP_SPEED_CURVE_POINTS(node_id)                                                 \
+    BUILD_ASSERT(DT_PROP_LEN(node_id, curve_points) >= 4 &&                            \
+                     DT_PROP_LEN(node_id, curve_points) % 2 == 0,                      \
+                 "curve-points must hold at least two <time_ms speed> pairs");          \
+    BUILD_ASSERT(DT_PROP_LEN(node_id, curve_points) / 2 <=                             \
+                     CONFIG_ZMK_INPUT_PROCESSOR_SPEED_CURVE_MAX_POINTS,                \
+                 "curve-points exceeds CONFIG_ZMK_INPUT_PROCESSOR_SPEED_CURVE_MAX_POINTS"); \
+    BUILD_ASSERT(ZIP_SPEED_CURVE_SEARCH_DEPTH(DT_PROP_LEN(node_id, curve_points) / 2) <=  \
+                     CONFIG_ZMK_INPUT_PROCESSOR_SPEED_CURVE_MAX_SEARCH_DEPTH,          \
+                 "curve-points needs more search steps than "                          \
+                 "CONFIG_ZMK_INPUT_PROCESSOR_SPEED_CURVE_MAX_SEARCH_DEPTH");            \
+    static const int32_t ZIP_SPEED_CURVE_NAME(zip_speed_curve_points_, node_id)[] =   \
+        DT_PROP(node_id, curve_points);
+
+#define ZIP_SPEED_CURVE_PROFILE(node_id)                                                \
+    {                                                                                   \
+        .curve_points = ZIP_SPEED_CURVE_NAME(zip_speed_curve_points_, node_id),       \
+        .curve_points_len = DT_PROP_LEN(node_id, curve_points),                        \
+        .interpolation = ZIP_SPEED_CURVE_INTERP_LINEAR,                                \
+    },
+
+// Memory-mapped address and size of the curve blob partition, if any
+#define ZIP_SPEED_CURVE_BLOB_PART(node_id) DT_PHANDLE(node_id, curve_partition)
+
+#define ZIP_SPEED_CURVE_BLOB(node_id)                                                   \
+    COND_CODE_1(DT_NODE_HAS_PROP(node_id, curve_partition),                            \
+                ((const void *)(DT_REG_ADDR(DT_GPARENT(ZIP_SPEED_CURVE_BLOB_PART(node_id))) + \
+                                DT_REG_ADDR(ZIP_SPEED_CURVE_BLOB_PART(node_id)))),     \
+                (NULL))
+
+#define ZIP_SPEED_CURVE_BLOB_SIZE(node_id)                                              \
+    COND_CODE_1(DT_NODE_HAS_PROP(node_id, curve_partition),                            \
+                (DT_REG_SIZE(ZIP_SPEED_CURVE_BLOB_PART(node_id))), (0))
+
+#define ZIP_SPEED_CURVE_BLOB_CHECK(node_id)                                             \
+    IF_ENABLED(DT_NODE_HAS_PROP(node_id, curve_partition),                             \
+               (BUILD_ASSERT(DT_NODE_HAS_COMPAT(DT_GPARENT(ZIP_SPEED_CURVE_BLOB_PART(node_id)), \
+                                                soc_nv_flash),                         \
+                             "curve-partition must be in memory-mapped flash");))
+
+// Output units per curve unit: hi-res wheel units per notch, or 1
+#define ZIP_SPEED_CURVE_OUTPUT_UNITS(node_id)                                           \
+    (DT_PROP(node_id, hi_res_scroll) ? ZIP_SPEED_CURVE_HI_RES_UNITS_PER_NOTCH : 1)
+
+// px/event per px/s as a 32.32 fixed-point factor, including the built-in scaler
+#define ZIP_SPEED_CURVE_MOVEMENT_SCALE(node_id)                                         \
+    ZIP_SPEED_CURVE_SCALE_32_32((uint64_t)DT_PROP(node_id, trigger_period_ms) *        \
+                                    DT_PROP(node_id, scale_multiplier) *               \
+                                    ZIP_SPEED_CURVE_OUTPUT_UNITS(node_id),             \
+                                1000ULL * DT_PROP(node_id, scale_divisor))
+
+// Scaler and output units as a 16.16 fixed-point factor (velocity input)
+#define ZIP_SPEED_CURVE_OUTPUT_GAIN(node_id)                                            \
+    ZIP_SPEED_CURVE_SCALE_16_16((uint64_t)DT_PROP(node_id, scale_multiplier) *         \
+                                    ZIP_SPEED_CURVE_OUTPUT_UNITS(node_id),             \
+                                DT_PROP(node_id, scale_divisor))
+
+// Group of each code and the per-group state, with axis-groups
+#define ZIP_SPEED_CURVE_GROUP_CHECK(node_id, prop, idx)                                 \
+    BUILD_ASSERT(DT_PROP_BY_IDX(node_id, prop, idx) < DT_PROP_LEN(node_id, codes),     \
+                 "axis-groups entries must be smaller than the number of codes");
+
+// Next code of the same group: the first one after idx, else the first one overall
+#define ZIP_SPEED_CURVE_GROUP_AFTER(j, node_id, idx)                                    \
+    (j > idx && DT_PROP_BY_IDX(node_id, axis_groups, j) ==                              \
+                    DT_PROP_BY_IDX(node_id, axis_groups, idx)) ? j :
+#define ZIP_SPEED_CURVE_GROUP_FIRST(j, node_id, idx)                                    \
+    (DT_PROP_BY_IDX(node_id, axis_groups, j) == DT_PROP_BY_IDX(node_id, axis_groups, idx)) ? j :
+#define ZIP_SPEED_CURVE_GROUP_NEXT(node_id, prop, idx)                                  \
+    (LISTIFY(DT_PROP_LEN(node_id, prop), ZIP_SPEED_CURVE_GROUP_AFTER, (), node_id, idx) \
+     LISTIFY(DT_PROP_LEN(node_id, prop), ZIP_SPEED_CURVE_GROUP_FIRST, (), node_id, idx) \
+     idx),
+
+#define ZIP_SPEED_CURVE_GROUPS(node_id)                                                 \
+    IF_ENABLED(DT_NODE_HAS_PROP(node_id, axis_groups),                                 \
+               (BUILD_ASSERT(DT_PROP_LEN(node_id, axis_groups) == DT_PROP_LEN(node_id, codes), \
+                             "axis-groups needs one entry per code");                  \
+                DT_FOREACH_PROP_ELEM(node_id, axis_groups, ZIP_SPEED_CURVE_GROUP_CHECK) \
+                static const uint8_t                                                   \
+                    ZIP_SPEED_CURVE_NAME(zip_speed_curve_groups_map_, node_id)[] =     \
+                        DT_PROP(node_id, axis_groups);                                 \
+                static const uint8_t                                                   \
+                    ZIP_SPEED_CURVE_NAME(zip_speed_curve_groups_next_, node_id)[] = {  \
+                        DT_FOREACH_PROP_ELEM(node_id, axis_groups,                     \
+                                             ZIP_SPEED_CURVE_GROUP_NEXT)};             \
+                static struct zip_speed_curve_group ZIP_SPEED_CURVE_NAME(              \
+                    zip_speed_curve_groups_, node_id)[DT_PROP_LEN(node_id, codes)];))
+
+// Capture buffer of an instance (CONFIG_ZMK_INPUT_PROCESSOR_SPEED_CURVE_TRACE)
+#define ZIP_SPEED_CURVE_TRACE(node_id)                                                  \
+    IF_ENABLED(CONFIG_ZMK_INPUT_PROCESSOR_SPEED_CURVE_TRACE,                           \
+               (static uint8_t ZIP_SPEED_CURVE_NAME(zip_speed_curve_trace_storage_, node_id) \
+                    [CONFIG_ZMK_INPUT_PROCESSOR_SPEED_CURVE_TRACE_SIZE];               \
+                static struct zip_speed_curve_trace                                    \
+                    ZIP_SPEED_CURVE_NAME(zip_speed_curve_trace_, node_id) = {          \
+                        .storage = ZIP_SPEED_CURVE_NAME(zip_speed_curve_trace_storage_, node_id), \
+                };))
+
+// Instantiated for both compatibles; only the -params variant receives cells
+#define ZIP_SPEED_CURVE_DEFINE(node_id)                                                 \
+    BUILD_ASSERT(DT_PROP(node_id, scale_divisor) > 0, "scale-divisor must be positive"); \
+    BUILD_ASSERT((uint64_t)DT_PROP(node_id, trigger_period_ms) *                        \
+                         DT_PROP(node_id, scale_multiplier) *                          \
+                         ZIP_SPEED_CURVE_OUTPUT_UNITS(node_id) <                       \
+                     (1ULL << 31),                                                     \
+                 "trigger-period-ms * scale-multiplier is too large");                  \
+    BUILD_ASSERT(ZIP_SPEED_CURVE_OUTPUT_GAIN(node_id) <= UINT32_MAX,                    \
+                 "scale-multiplier / scale-divisor is too large");                      \
+    BUILD_ASSERT(IN_RANGE(DT_PROP(node_id, max_output), 0, INT16_MAX),                 \
+                 "max-output must be between 1 and 32767, or 0 for the Kconfig default"); \
+    BUILD_ASSERT(IN_RANGE(DT_PROP(node_id, distance_reset_ms), 0, UINT16_MAX),        \
+                 "distance-reset-ms must be between 0 and 65535");                      \
+    BUILD_ASSERT(IN_RANGE(DT_PROP(node_id, resume_window_ms), 0, UINT16_MAX),         \
+                 "resume-window-ms must be between 0 and 65535");                       \
+    BUILD_ASSERT(IN_RANGE(DT_PROP(node_id, resume_retain_percent), 0, 100),             \
+                 "resume-retain-percent must be between 0 and 100");                    \
+    BUILD_ASSERT(IN_RANGE(DT_PROP(node_id, reversal_frames), 0, UINT8_MAX),            \
+                 "reversal-frames must be between 0 and 255");                          \
+    BUILD_ASSERT(IN_RANGE(DT_PROP(node_id, reversal_threshold), 0, UINT16_MAX),        \
+                 "reversal-threshold must be between 0 and 65535");                     \
+    BUILD_ASSERT(IN_RANGE(DT_PROP(node_id, prediction_ms), 0, UINT16_MAX),             \
+                 "prediction-ms must be between 0 and 65535");                          \
+    ZIP_SPEED_CURVE_BLOB_CHECK(node_id)                                                \
+    static const uint16_t ZIP_SPEED_CURVE_NAME(zip_speed_curve_codes_, node_id)[] =   \
+        DT_PROP(node_id, codes);                                                       \
+    ZIP_SPEED_CURVE_GROUPS(node_id)                                                    \
+    ZIP_SPEED_CURVE_POINTS(node_id)                                              \
+    DT_FOREACH_CHILD(node_id, ZIP_SPEED_CURVE_POINTS)                            \
+    static const struct zip_speed_curve_profile                                        \
+        ZIP_SPEED_CURVE_NAME(zip_speed_curve_profiles_, node_id)[] = {                 \
+            ZIP_SPEED_CURVE_PROFILE(node_id)                                           \
+            DT_FOREACH_CHILD(node_id, ZIP_SPEED_CURVE_PROFILE)                         \
+    };                                                                                  \
+    static const struct zip_speed_curve_config                                         \
+        ZIP_SPEED_CURVE_NAME(zip_speed_curve_config_, node_id) = {                     \
+        .type = DT_PROP(node_id, type),                                                \
+        .codes = ZIP_SPEED_CURVE_NAME(zip_speed_curve_codes_, node_id),               \
+        .codes_len = DT_PROP_LEN(node_id, codes),                                      \
+        .profiles = ZIP_SPEED_CURVE_NAME(zip_speed_curve_profiles_, node_id),         \
+        .profiles_len = ARRAY_SIZE(ZIP_SPEED_CURVE_NAME(zip_speed_curve_profiles_, node_id)), \
+        .trigger_period_ms = DT_PROP(node_id, trigger_period_ms),                      \
+        .movement_scale = ZIP_SPEED_CURVE_MOVEMENT_SCALE(node_id),                     \
+        .output_gain = ZIP_SPEED_CURVE_OUTPUT_GAIN(node_id),                           \
+        .track_remainders = DT_PROP_OR(node_id, track_remainders, false),              \
+        .suppress_zero_events = DT_PROP(node_id, suppress_zero_events) ||              \
+                                DT_PROP(node_id, coalesce_reports),                    \
+        .coalesce_reports = DT_PROP(node_id, coalesce_reports),                        \
+        .curve_input = DT_ENUM_IDX(node_id, curve_input),                              \
+        .distance_reset_ms = DT_PROP(node_id, distance_reset_ms),                      \
+        .resume_window_ms = DT_PROP(node_id, resume_window_ms),                        \
+        .resume_retain_percent = DT_PROP(node_id, resume_retain_percent),              \
+        .reversal_frames = DT_PROP(node_id, reversal_frames),                          \
+        .reversal_threshold = DT_PROP(node_id, reversal_threshold),                    \
+        .velocity_filter = DT_ENUM_IDX(node_id, velocity_filter),                      \
+        .filter_min_cutoff_mhz = DT_PROP(node_id, filter_min_cutoff_mhz),              \
+        .filter_d_cutoff_mhz = DT_PROP(node_id, filter_d_cutoff_mhz),                  \
+        .filter_beta = DT_PROP(node_id, filter_beta),                                  \
+        .prediction_ms = DT_PROP(node_id, prediction_ms),                              \
+        .axis_groups = COND_CODE_1(DT_NODE_HAS_PROP(node_id, axis_groups),             \
+                                   (ZIP_SPEED_CURVE_NAME(zip_speed_curve_groups_map_, node_id)), \
+                                   (NULL)),                                            \
+        .group_next = COND_CODE_1(DT_NODE_HAS_PROP(node_id, axis_groups),              \
+                                  (ZIP_SPEED_CURVE_NAME(zip_speed_curve_groups_next_, node_id)), \
+                                  (NULL)),                                             \
+        .max_output = DT_PROP(node_id, max_output) != 0                                \
+                          ? DT_PROP(node_id, max_output)                               \
+                          : CONFIG_ZMK_INPUT_PROCESSOR_SPEED_CURVE_MAX_OUTPUT,         \
+        .blob = ZIP_SPEED_CURVE_BLOB(node_id),                                         \
+        .blob_size = ZIP_SPEED_CURVE_BLOB_SIZE(node_id),                               \
+    };                                                                                  \
+    static struct zip_speed_curve_axis                                                 \
+        ZIP_SPEED_CURVE_NAME(zip_speed_curve_axes_, node_id)[DT_PROP_LEN(node_id, codes)]; \
+    ZIP_SPEED_CURVE_TRACE(node_id)                                                     \
+    static struct zip_speed_curve_data ZIP_SPEED_CURVE_NAME(zip_speed_curve_data_, node_id) = { \
+        .axes = ZIP_SPEED_CURVE_NAME(zip_speed_curve_axes_, node_id),                  \
+        .groups = COND_CODE_1(DT_NODE_HAS_PROP(node_id, axis_groups),                  \
+                              (ZIP_SPEED_CURVE_NAME(zip_speed_curve_groups_, node_id)), (NULL)), \
+        .trace = COND_CODE_1(CONFIG_ZMK_INPUT_PROCESSOR_SPEED_CURVE_TRACE,             \
+                             (&ZIP_SPEED_CURVE_NAME(zip_speed_curve_trace_, node_id)), (NULL)), \
     };                                                                                  \
-    static struct zip_speed_curve_data zip_speed_curve_data_##n = {};                 \
-    DEVICE_DT_INST_DEFINE(n, zip_speed_curve_init, NULL,                              \
-                          &zip_speed_curve_data_##n, &zip_speed_curve_config_##n,     \
-                          POST_KERNEL, CONFIG_KERNEL_INIT_PRIORITY_DEFAULT,            \
-                          &zip_speed_curve_driver_api);
+    DEVICE_DT_DEFINE(node_id, zip_speed_curve_init, NULL,                              \
+                     &ZIP_SPEED_CURVE_NAME(zip_speed_curve_data_, node_id),            \
+                     &ZIP_SPEED_CURVE_NAME(zip_speed_curve_config_, node_id),          \
+                     POST_KERNEL, CONFIG_KERNEL_INIT_PRIORITY_DEFAULT,                 \
+                     &zip_speed_curve_driver_api);
 
-DT_INST_FOREACH_STATUS_OKAY(ZIP_SPEED_CURVE_INST)
+DT_FOREACH_STATUS_OKAY(zmk_input_processor_speed_curve, ZIP_SPEED_CURVE_DEFINE)
+DT_FOREACH_STATUS_OKAY(zmk_input_processor_speed_curve_params, ZIP_SPEED_CURVE_DEFINE)
@@ -0,0 +1,229 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <dt-bindings/zmk/speed_curve.h>
+#include <zmk/input_processors/speed_curve_engine.h>
+
+// Largest r of zip_speed_curve_lowpass_alpha() that can still be shifted
+#define LOWPASS_MAX_R (INT64_MAX >> (ZIP_SPEED_CURVE_FRAC_BITS + 1))
+
+bool zip_speed_curve_profile_valid(const struct zip_speed_curve_profile *profile) {
+    const int32_t *points = profile->curve_points;
+    size_t num_points = profile->curve_points_len / 2;
+
+    if (points == NULL || num_points < 2 || profile->curve_points_len % 2 != 0) {
+        return false;
+    }
+
+    for (size_t i = 0; i < num_points; i++) {
+        int32_t t = points[i * 2];
+        int32_t s = points[i * 2 + 1];
+
+        if (t < 0 || s < 0 || s > ZIP_SPEED_CURVE_MAX_SPEED) {
+            return false;
+        }
+        if (i == 0) {
+            continue;
+        }
+
+        int32_t t0 = points[(i - 1) * 2];
+        int32_t s0 = points[(i - 1) * 2 + 1];
+        if (t <= t0) {
+            return false;
+        }
+
+        // Same rounding as scripts/speed_curve_blob.py; multiplied, since the speed
+        // difference may be negative and must not be shifted
+        int64_t slope = (int64_t)(s - s0) * (1 << ZIP_SPEED_CURVE_FRAC_BITS) / (t - t0);
+        if (profile->slopes != NULL && profile->slopes[i - 1] != slope) {
+            return false;
+        }
+    }
+
+    if (profile->lut != NULL && profile->lut_shift >= ZIP_SPEED_CURVE_FRAC_BITS) {
+        return false;
+    }
+
+    for (size_t i = 0; profile->lut != NULL && i < profile->lut_len; i++) {
+        if (profile->lut[i] < 0 || profile->lut[i] > ZIP_SPEED_CURVE_MAX_SPEED) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Calculate speed at given elapsed time using piecewise linear interpolation
+ *
+ * @param use_tables Use the profile's precomputed LUT and slopes where present
+ */
+static int32_t evaluate(const struct zip_speed_curve_profile *profile, int64_t elapsed_ms,
+                        bool use_tables) {
+    // Curve points are stored as [time0, speed0, time1, speed1, ...]
+    size_t num_points = profile->curve_points_len / 2;
+    
+    if (num_points == 0) {
+        return 0;
+    }
+    
+    // If before first point, use first point's speed
+    int32_t first_time = profile->curve_points[0];
+    int32_t first_speed = profile->curve_points[1];
+    
+    if (elapsed_ms <= first_time) {
+        return first_speed;
+    }
+    
+    // If after last point, use last point's speed
+    int32_t last_time = profile->curve_points[(num_points - 1) * 2];
+    int32_t last_speed = profile->curve_points[(num_points - 1) * 2 + 1];
+    
+    if (elapsed_ms >= last_time) {
+        return last_speed;
+    }
+
+    // Precomputed table (curve blobs only): interpolate between table entries. Step curves
+    // keep their hard edges, a table would turn every step into a ramp.
+    if (use_tables && profile->lut != NULL &&
+        profile->interpolation != ZIP_SPEED_CURVE_INTERP_STEP) {
+        unsigned int step_shift = profile->lut_shift;
+        int64_t lut_index = elapsed_ms >> step_shift;
+
+        if (profile->lut_log) {
+            // elapsed_ms > first_time >= 0 here, so the leading-zero count is defined
+            int excess = 63 - __builtin_clzll((uint64_t)elapsed_ms) - profile->lut_shift;
+            step_shift = excess > 0 ? excess : 0;
+            lut_index = ((int64_t)step_shift << profile->lut_shift) + (elapsed_ms >> step_shift);
+        }
+
+        if (lut_index + 1 < profile->lut_len) {
+            int64_t s0 = profile->lut[lut_index];
+            int64_t s1 = profile->lut[lut_index + 1];
+            int64_t frac = elapsed_ms & ((INT64_C(1) << step_shift) - 1);
+            return s0 + (((s1 - s0) * frac) >> step_shift);
+        }
+    }
+    
+    // Binary search for the segment [i, i + 1] holding elapsed_ms; the checks above
+    // guarantee t[0] < elapsed_ms < t[n - 1], so this takes at most
+    // zip_speed_curve_search_depth() steps
+    size_t i = 0;
+    size_t hi = num_points - 1;
+    while (hi - i > 1) {
+        size_t mid = (i + hi) / 2;
+        if (elapsed_ms < profile->curve_points[mid * 2]) {
+            hi = mid;
+        } else {
+            i = mid;
+        }
+    }
+
+    int32_t t0 = profile->curve_points[i * 2];
+    int32_t s0 = profile->curve_points[i * 2 + 1];
+    int32_t t1 = profile->curve_points[(i + 1) * 2];
+    int32_t s1 = profile->curve_points[(i + 1) * 2 + 1];
+
+    if (profile->interpolation == ZIP_SPEED_CURVE_INTERP_STEP) {
+        return s0;
+    }
+
+    // Precomputed slope (curve blobs only) avoids the division
+    if (use_tables && profile->slopes != NULL) {
+        return s0 + ((profile->slopes[i] * (elapsed_ms - t0)) >> ZIP_SPEED_CURVE_FRAC_BITS);
+    }
+
+    // Linear interpolation: speed = s0 + (s1 - s0) * (t - t0) / (t1 - t0)
+    int64_t time_delta = t1 - t0;
+    int64_t speed_delta = s1 - s0;
+    int64_t elapsed_in_segment = elapsed_ms - t0;
+
+    return s0 + (speed_delta * elapsed_in_segment) / time_delta;
+}
+
+unsigned int zip_speed_curve_search_depth(size_t num_points) {
+    unsigned int depth = 0;
+
+    // Each step halves the number of candidate segments
+    for (size_t segments = num_points > 1 ? num_points - 1 : 1; segments > 1;
+         segments = (segments + 1) / 2) {
+        depth++;
+    }
+    return depth;
+}
+
+int32_t zip_speed_curve_eval(const struct zip_speed_curve_profile *profile, int64_t elapsed_ms) {
+    return evaluate(profile, elapsed_ms, true);
+}
+
+int32_t zip_speed_curve_eval_reference(const struct zip_speed_curve_profile *profile,
+                                       int64_t elapsed_ms) {
+    return evaluate(profile, elapsed_ms, false);
+}
+
+int64_t zip_speed_curve_track_remainder(int64_t movement, int32_t *remainder, bool track) {
+    movement += *remainder;
+    *remainder = track ? movement & ZIP_SPEED_CURVE_FRAC_MASK : 0;
+    return movement >> ZIP_SPEED_CURVE_FRAC_BITS;
+}
+
+int64_t zip_speed_curve_mul_sat(int64_t a, int64_t b) {
+    int64_t product;
+
+    if (__builtin_mul_overflow(a, b, &product)) {
+        return (a < 0) != (b < 0) ? INT64_MIN : INT64_MAX;
+    }
+    return product;
+}
+
+int64_t zip_speed_curve_apply_gain(int64_t movement, uint32_t gain) {
+    if (gain == 0) {
+        return movement;
+    }
+
+    uint16_t gain_num = ZIP_SPEED_CURVE_GAIN_NUM(gain);
+    uint16_t gain_den = ZIP_SPEED_CURVE_GAIN_DEN(gain);
+    return zip_speed_curve_mul_sat(movement, gain_num) / (gain_den != 0 ? gain_den : 1);
+}
+
+uint32_t zip_speed_curve_isqrt64(uint64_t value) {
+    uint64_t root = 0;
+    uint64_t bit = 1ULL << 62;
+
+    while (bit > value) {
+        bit >>= 2;
+    }
+
+    while (bit != 0) {
+        if (value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    return root;
+}
+
+uint64_t zip_speed_curve_norm_sq2_portable(int32_t x, int32_t y) {
+    return (uint64_t)((int64_t)x * x) + (uint64_t)((int64_t)y * y);
+}
+
+#if !defined(CONFIG_ZMK_INPUT_PROCESSOR_SPEED_CURVE_DSP)
+uint64_t zip_speed_curve_norm_sq2(int32_t x, int32_t y) {
+    return zip_speed_curve_norm_sq2_portable(x, y);
+}
+#endif
+
+int64_t zip_speed_curve_lowpass_alpha(int64_t cutoff_mhz, int64_t interval_us) {
+    int64_t r =
+        zip_speed_curve_mul_sat(zip_speed_curve_mul_sat(6283, cutoff_mhz), interval_us) / 1000;
+
+    r = r < LOWPASS_MAX_R ? r : LOWPASS_MAX_R;
+    return (r << ZIP_SPEED_CURVE_FRAC_BITS) / (1000000000LL + r);
+}
@@ -0,0 +1,26 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Parts of the curve engine that use the Cortex-M DSP extension
+ * (CONFIG_ZMK_INPUT_PROCESSOR_SPEED_CURVE_DSP). Each function gives the same
+ * result as its portable version in src/speed_curve_engine.c.
+ */
+
+#include <cmsis_core.h>
+
+#include <zmk/input_processors/speed_curve_engine.h>
+
+uint64_t zip_speed_curve_norm_sq2(int32_t x, int32_t y) {
+    if (x < INT16_MIN || x > INT16_MAX || y < INT16_MIN || y > INT16_MAX) {
+        return zip_speed_curve_norm_sq2_portable(x, y);
+    }
+
+    // Both values in one register, x in the bottom halfword; SMUAD multiplies the
+    // halfwords pairwise and adds. The sum is at most 2^31, so it fits as unsigned.
+    uint32_t packed = __PKHBT((uint32_t)x, (uint32_t)y, 16);
+    return (uint32_t)__SMUAD(packed, packed);
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/*
+ * Instruction budgets of the hot path, per board, engine and curve size.
+ *
+ * "eval" is one zip_speed_curve_eval() call, "event" one event through the
+ * processor (frames input, remainders on), both averaged over a sweep of
+ * the whole curve. Budgets are the figures this suite measured plus
+ * BENCH_MARGIN_PERCENT, rounded up; the suite prints them in this layout.
+ * A table of zeros has not been measured yet: the suite prints the table
+ * to paste here and skips the check. Lower a budget when an optimization
+ * lands, and only raise one with a reason in the commit that does.
+ */
+
+// Headroom over the measured figures, for toolchain and Zephyr updates
+#define BENCH_MARGIN_PERCENT 10
+
+enum bench_engine {
+    BENCH_SEARCH,  // Curve points only: segment search and division
+    BENCH_SLOPES,  // Precomputed slopes
+    BENCH_LUT,     // Uniform lookup table (and slopes)
+    BENCH_LUT_LOG, // Log-spaced lookup table (and slopes)
+    BENCH_ENGINES,
+};
+
+// Curve sizes in points, as the instances of app.overlay
+#define BENCH_CURVE_SIZES {2, 8, 32}
+#define BENCH_SIZES 3
+
+struct bench_budget {
+    uint32_t eval;  // Instructions per curve evaluation
+    uint32_t event; // Instructions per processed event
+};
+
+#if defined(CONFIG_BOARD_QEMU_CORTEX_M0)
+// ARMv6-M: no hardware division, 64-bit multiplies and divisions in libgcc. Not measured yet.
+static const struct bench_budget bench_budgets[BENCH_ENGINES][BENCH_SIZES] = {
+    [BENCH_SEARCH] = {{0, 0}, {0, 0}, {0, 0}},
+    [BENCH_SLOPES] = {{0, 0}, {0, 0}, {0, 0}},
+    [BENCH_LUT] = {{0, 0}, {0, 0}, {0, 0}},
+    [BENCH_LUT_LOG] = {{0, 0}, {0, 0}, {0, 0}},
+};
+#elif defined(CONFIG_BOARD_QEMU_CORTEX_M3)
+// ARMv7-M: 32-bit hardware division and long multiplies. Not measured yet.
+static const struct bench_budget bench_budgets[BENCH_ENGINES][BENCH_SIZES] = {
+    [BENCH_SEARCH] = {{0, 0}, {0, 0}, {0, 0}},
+    [BENCH_SLOPES] = {{0, 0}, {0, 0}, {0, 0}},
+    [BENCH_LUT] = {{0, 0}, {0, 0}, {0, 0}},
+    [BENCH_LUT_LOG] = {{0, 0}, {0, 0}, {0, 0}},
+};
+#elif defined(CONFIG_BOARD_MPS2_AN386)
+// ARMv7E-M (Cortex-M4): as ARMv7-M, plus the DSP extension. Not measured yet.
+static const struct bench_budget bench_budgets[BENCH_ENGINES][BENCH_SIZES] = {
+    [BENCH_SEARCH] = {{0, 0}, {0, 0}, {0, 0}},
+    [BENCH_SLOPES] = {{0, 0}, {0, 0}, {0, 0}},
+    [BENCH_LUT] = {{0, 0}, {0, 0}, {0, 0}},
+    [BENCH_LUT_LOG] = {{0, 0}, {0, 0}, {0, 0}},
+};
+#else
+#error "No instruction budgets for this board"
+#endif
@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Instruction budgets of the speed curve hot path.
+ *
+ * Runs under QEMU in icount mode, where virtual time advances a fixed
+ * 2^CONFIG_QEMU_ICOUNT_SHIFT ns per executed instruction: the elapsed time
+ * of a benchmark is its instruction count, the same on every run and host.
+ * Each engine and curve size is measured for curve evaluation alone and for
+ * a full event through the processor, and checked against budgets.h.
+ *
+ * The processors are the devicetree instances of app.overlay, built by the
+ * module as in firmware. The precomputed engines replace an instance's
+ * curve through its blob profile, as a loaded curve blob would.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/dt-bindings/input/input-event-codes.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/ztest.h>
+#include <drivers/input_processor.h>
+
+#include <zmk/input_processors/speed_curve.h>
+
+#include "budgets.h"
+
+// The processor logs to ZMK's log module
+LOG_MODULE_REGISTER(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+BUILD_ASSERT(IS_ENABLED(CONFIG_QEMU_ICOUNT), "instruction counts need QEMU icount mode");
+
+#define PERIOD_MS 16
+#define RUNS 4096
+// The sweep covers the curve once, frame by frame
+#define CURVE_SPAN_MS (RUNS * PERIOD_MS)
+#define MAX_LUT_LEN 1024
+#define LUT_SHIFT 7
+#define LUT_LOG_SHIFT 4
+
+static const char *const engine_names[BENCH_ENGINES] = {"search", "slopes", "lut", "lut-log"};
+static const char *const engine_enums[BENCH_ENGINES] = {"BENCH_SEARCH", "BENCH_SLOPES",
+                                                        "BENCH_LUT", "BENCH_LUT_LOG"};
+static const size_t curve_sizes[BENCH_SIZES] = BENCH_CURVE_SIZES;
+
+// One instance per curve size, in the order of BENCH_CURVE_SIZES
+static const struct device *const processors[BENCH_SIZES] = {
+    DEVICE_DT_GET(DT_NODELABEL(bench_curve_2)),
+    DEVICE_DT_GET(DT_NODELABEL(bench_curve_8)),
+    DEVICE_DT_GET(DT_NODELABEL(bench_curve_32)),
+};
+
+BUILD_ASSERT(DT_PROP_BY_IDX(DT_NODELABEL(bench_curve_2), curve_points, 2) == CURVE_SPAN_MS,
+             "app.overlay curves must span CURVE_SPAN_MS");
+
+static int32_t slopes[CONFIG_ZMK_INPUT_PROCESSOR_SPEED_CURVE_MAX_POINTS];
+static int32_t lut[MAX_LUT_LEN];
+static struct zip_speed_curve_profile profile;
+static struct bench_budget measured[BENCH_ENGINES][BENCH_SIZES];
+
+static int64_t lut_time(size_t index, bool log_spacing, unsigned int shift) {
+    if (!log_spacing) {
+        return (int64_t)index << shift;
+    }
+    unsigned int e = (index >> shift) > 0 ? (index >> shift) - 1 : 0;
+    return (int64_t)(index - ((size_t)e << shift)) << e;
+}
+
+static size_t lut_index(int64_t t, bool log_spacing, unsigned int shift) {
+    if (!log_spacing) {
+        return t >> shift;
+    }
+    int msb = t > 0 ? 63 - __builtin_clzll(t) : 0;
+    unsigned int step = msb > (int)shift ? msb - shift : 0;
+    return ((size_t)step << shift) + (t >> step);
+}
+
+/**
+ * @brief Give a processor's devicetree curve the tables of an engine
+ *
+ * The processor uses the result in place of its devicetree curve.
+ */
+static void build_profile(const struct device *dev, enum bench_engine engine) {
+    const struct zip_speed_curve_config *cfg = dev->config;
+    struct zip_speed_curve_data *data = dev->data;
+    const int32_t *points = cfg->profiles[0].curve_points;
+    size_t num_points = cfg->profiles[0].curve_points_len / 2;
+
+    profile = cfg->profiles[0];
+    data->blob_profile = (struct zip_speed_curve_profile){0};
+    if (engine == BENCH_SEARCH) {
+        return;
+    }
+
+    // Tables as scripts/speed_curve_blob.py builds them; both LUTs fit MAX_LUT_LEN
+    for (size_t i = 0; i + 1 < num_points; i++) {
+        int64_t ds = points[(i + 1) * 2 + 1] - points[i * 2 + 1];
+        slopes[i] = ds * (1 << ZIP_SPEED_CURVE_FRAC_BITS) / (points[(i + 1) * 2] - points[i * 2]);
+    }
+    profile.slopes = slopes;
+
+    if (engine == BENCH_LUT || engine == BENCH_LUT_LOG) {
+        bool log_spacing = engine == BENCH_LUT_LOG;
+        unsigned int shift = log_spacing ? LUT_LOG_SHIFT : LUT_SHIFT;
+        int32_t last_time = points[(num_points - 1) * 2];
+
+        profile.lut = lut;
+        profile.lut_len = lut_index(last_time, log_spacing, shift) + 2;
+        profile.lut_shift = shift;
+        profile.lut_log = log_spacing;
+        for (size_t i = 0; i < profile.lut_len; i++) {
+            lut[i] = zip_speed_curve_eval_reference(&profile, lut_time(i, log_spacing, shift));
+        }
+    }
+
+    zassert_true(zip_speed_curve_profile_valid(&profile), "%s curve is invalid",
+                 engine_names[engine]);
+    data->blob_profile = profile;
+}
+
+/**
+ * @brief Instructions per run, from the icount virtual time of RUNS runs
+ */
+static uint32_t instructions(uint32_t cycles) {
+    return (k_cyc_to_ns_floor64(cycles) >> CONFIG_QEMU_ICOUNT_SHIFT) / RUNS;
+}
+
+static uint32_t bench_eval(void) {
+    volatile int32_t sink;
+    uint32_t start = k_cycle_get_32();
+
+    for (int i = 0; i < RUNS; i++) {
+        sink = zip_speed_curve_eval(&profile, i * PERIOD_MS);
+    }
+
+    return instructions(k_cycle_get_32() - start);
+}
+
+static uint32_t bench_event(const struct device *dev) {
+    const struct zmk_input_processor_driver_api *api = dev->api;
+
+    // Frames input walks the curve one trigger period per event, whatever
+    // the virtual clock does
+    zassert_ok(zip_speed_curve_reset(dev));
+
+    uint32_t start = k_cycle_get_32();
+
+    for (int i = 0; i < RUNS; i++) {
+        struct input_event event = {
+            .sync = true,
+            .type = INPUT_EV_REL,
+            .code = INPUT_REL_X,
+            .value = 1,
+        };
+        api->handle_event(dev, &event, 0, 0, NULL);
+    }
+
+    return instructions(k_cycle_get_32() - start);
+}
+
+/**
+ * @brief Print the measured figures plus the margin, laid out like budgets.h
+ */
+static void print_budgets(void) {
+    TC_PRINT("Measured plus %d%%, for %s in budgets.h:\n", BENCH_MARGIN_PERCENT, CONFIG_BOARD);
+    for (int e = 0; e < BENCH_ENGINES; e++) {
+        TC_PRINT("    [%s] = {", engine_enums[e]);
+        for (int s = 0; s < BENCH_SIZES; s++) {
+            TC_PRINT("%s{%u, %u}", s > 0 ? ", " : "",
+                     DIV_ROUND_UP(measured[e][s].eval * (100 + BENCH_MARGIN_PERCENT), 100),
+                     DIV_ROUND_UP(measured[e][s].event * (100 + BENCH_MARGIN_PERCENT), 100));
+        }
+        TC_PRINT("},\n");
+    }
+}
+
+ZTEST(speed_curve_cycle_budget, test_hot_path) {
+    int over = 0;
+    bool unmeasured = false;
+
+    for (int s = 0; s < BENCH_SIZES; s++) {
+        zassert_true(device_is_ready(processors[s]), "%zu point processor not ready",
+                     curve_sizes[s]);
+    }
+
+    for (int e = 0; e < BENCH_ENGINES; e++) {
+        for (int s = 0; s < BENCH_SIZES; s++) {
+            const struct bench_budget *budget = &bench_budgets[e][s];
+            struct bench_budget *result = &measured[e][s];
+
+            build_profile(processors[s], e);
+            result->eval = bench_eval();
+            result->event = bench_event(processors[s]);
+
+            TC_PRINT("%-7s %2zu points: %5u instructions/eval (budget %5u), "
+                     "%5u/event (budget %5u)%s\n",
+                     engine_names[e], curve_sizes[s], result->eval, budget->eval,
+                     result->event, budget->event,
+                     budget->eval == 0 ? "  UNMEASURED"
+                     : result->eval > budget->eval || result->event > budget->event
+                         ? "  OVER BUDGET"
+                         : "");
+            if (budget->eval == 0 || budget->event == 0) {
+                unmeasured = true;
+                continue;
+            }
+            over += (result->eval > budget->eval) + (result->event > budget->event);
+        }
+    }
+
+    print_budgets();
+    zassert_equal(over, 0, "%d benchmarks over their instruction budget", over);
+    if (unmeasured) {
+        ztest_test_skip();
+    }
+}
+
+ZTEST_SUITE(speed_curve_cycle_budget, NULL, NULL, NULL, NULL, NULL);
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Bit-exact test of the DSP engine (src/speed_curve_engine_dsp.c) against
+ * the portable C path, on the target itself. tests/host/dsp.c runs the same
+ * comparison with emulated intrinsics.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/ztest.h>
+
+#include <zmk/input_processors/speed_curve_engine.h>
+
+// The processor logs to ZMK's log module
+LOG_MODULE_REGISTER(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#define RANDOM_PAIRS 100000
+
+// Values around the 16-bit lanes' limits and the int32 extremes
+static const int32_t edges[] = {
+    0, 1, -1, 127, -128, 255, -255, INT16_MAX, INT16_MIN, -INT16_MAX, INT16_MAX + 1,
+    INT16_MIN - 1, 65535, -65536, INT32_MAX, -INT32_MAX,
+};
+
+static uint32_t rng_state = 1;
+
+static uint32_t rng(void) {
+    // xorshift32
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+// Mostly values that fit the 16-bit lanes, sometimes any int32 above INT32_MIN
+static int32_t random_value(void) {
+    switch (rng() % 4) {
+    case 0:
+        return (int32_t)(rng() % 255) - 127;
+    case 1:
+    case 2:
+        return (int16_t)rng();
+    default:
+        return MAX((int32_t)rng(), -INT32_MAX);
+    }
+}
+
+static void check(int32_t x, int32_t y) {
+    uint64_t dsp = zip_speed_curve_norm_sq2(x, y);
+    uint64_t portable = zip_speed_curve_norm_sq2_portable(x, y);
+
+    zassert_equal(dsp, portable, "norm_sq2(%d, %d): %llu, portable %llu", (int)x, (int)y, dsp,
+                  portable);
+}
+
+ZTEST(speed_curve_dsp, test_engine_selected) {
+    // The DSP engine is used exactly where the core has the extension
+    zassert_equal(IS_ENABLED(CONFIG_ZMK_INPUT_PROCESSOR_SPEED_CURVE_DSP),
+                  IS_ENABLED(CONFIG_ARMV7_M_ARMV8_M_DSP));
+}
+
+ZTEST(speed_curve_dsp, test_norm_sq2_edges) {
+    for (size_t i = 0; i < ARRAY_SIZE(edges); i++) {
+        for (size_t j = 0; j < ARRAY_SIZE(edges); j++) {
+            check(edges[i], edges[j]);
+        }
+    }
+}
+
+ZTEST(speed_curve_dsp, test_norm_sq2_random) {
+    for (int i = 0; i < RANDOM_PAIRS; i++) {
+        check(random_value(), random_value());
+    }
+}
+
+ZTEST_SUITE(speed_curve_dsp, NULL, NULL, NULL, NULL, NULL);
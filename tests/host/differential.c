@@ -0,0 +1,555 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Differential test of the curve engines against the original implementation.
+ *
+ * Every scenario draws a random curve, output scaling and event stream, and
+ * runs it through the processor once per engine (segment search, precomputed
+ * slopes, uniform and log-spaced lookup tables) next to a port of the
+ * original float calculate_speed() + track_remainder() event path.
+ *
+ * The float model is what users were used to, but it rounds too, so each
+ * engine's output is also held against exact rational arithmetic: a pixel
+ * may only differ from it where the engine's documented fixed-point error
+ * (16 fraction bits per frame, movement scale rounded up) can carry the
+ * value across a whole pixel. Speeds are checked at every millisecond of
+ * the curve. The float model's budgets apply while an engine gets the
+ * original speed; slopes and tables may not, within their speed budgets.
+ * Any budget violation fails the run.
+ *
+ * Usage: differential [seed] [scenarios]
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "speed_curve_host.h"
+
+#define MAX_POINTS 12
+#define MAX_LUT_LEN 4096
+
+// Speed budgets against the original calculate_speed(), in px/s
+#define SLOPE_SPEED_BUDGET 1 // truncated 16.16 slopes
+#define LUT_SPEED_BUDGET 2   // cells without a breakpoint, else the table's own error (lut_error())
+
+// Event path budgets against the float model, in px
+#define FRAME_BUDGET 1 // per-frame deviation
+#define DRIFT_BUDGET 1 // cumulative deviation within a movement, with remainders
+
+enum engine {
+    ENGINE_SEARCH,
+    ENGINE_SLOPES,
+    ENGINE_LUT,
+    ENGINE_LUT_LOG,
+    ENGINE_COUNT,
+};
+
+static const char *const engine_names[ENGINE_COUNT] = {"search", "slopes", "lut", "lut-log"};
+
+struct curve {
+    int32_t points[MAX_POINTS * 2];
+    int32_t slopes[MAX_POINTS];
+    int32_t lut[ENGINE_COUNT][MAX_LUT_LEN];
+    struct zip_speed_curve_profile profiles[ENGINE_COUNT];
+};
+
+struct engine_stats {
+    int64_t frames;
+    int32_t max_speed_error;
+    int32_t max_speed_budget;
+    int32_t max_frame_deviation;
+    int64_t max_drift;
+    int64_t exact_mismatches;
+    int64_t violations;
+};
+
+static struct engine_stats stats[ENGINE_COUNT];
+static uint64_t rng_state;
+
+static uint32_t rnd(void) {
+    // xorshift64*
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return (rng_state * 0x2545F4914F6CDD1DULL) >> 32;
+}
+
+static int32_t rnd_range(int32_t lo, int32_t hi) { return lo + (int32_t)(rnd() % (hi - lo + 1)); }
+
+/*
+ * Original implementation
+ */
+
+static int32_t original_speed(const int32_t *points, size_t num_points, bool step,
+                              int64_t elapsed_ms) {
+    if (elapsed_ms <= points[0]) {
+        return points[1];
+    }
+    if (elapsed_ms >= points[(num_points - 1) * 2]) {
+        return points[(num_points - 1) * 2 + 1];
+    }
+
+    for (size_t i = 0; i < num_points - 1; i++) {
+        int32_t t0 = points[i * 2];
+        int32_t s0 = points[i * 2 + 1];
+        int32_t t1 = points[(i + 1) * 2];
+        int32_t s1 = points[(i + 1) * 2 + 1];
+
+        if (elapsed_ms >= t0 && elapsed_ms < t1) {
+            if (step) {
+                return s0;
+            }
+            return s0 + ((int64_t)(s1 - s0) * (elapsed_ms - t0)) / (t1 - t0);
+        }
+    }
+    return points[(num_points - 1) * 2 + 1];
+}
+
+static void original_track_remainder(float *move, float *remainder) {
+    float new_move = *move + *remainder;
+    *remainder = new_move - (int)new_move;
+    *move = (int)new_move;
+}
+
+struct original_axis {
+    int8_t last_direction;
+    int64_t start_time;
+    int64_t last_event_time;
+    float remainder;
+};
+
+/*
+ * Exact reference: the movement of a movement so far as a fraction over den
+ */
+
+struct exact_axis {
+    int64_t num;      // Movement so far, over den
+    int64_t inexact;  // Frames whose movement is not a multiple of 2^-16 px
+    int64_t speeds;   // Sum of (speed + 1) over the movement
+    int64_t emitted;  // Pixels the engine emitted in this movement
+    int64_t original; // Pixels the float model emitted in this movement
+    bool diverged;    // Engine speed differed from the original in this movement
+};
+
+/*
+ * Lookup tables, built the way scripts/speed_curve_blob.py builds them
+ */
+
+static int64_t lut_time(size_t index, bool log_spacing, unsigned int shift) {
+    if (!log_spacing) {
+        return (int64_t)index << shift;
+    }
+    unsigned int e = (index >> shift) > 0 ? (index >> shift) - 1 : 0;
+    return (int64_t)(index - ((size_t)e << shift)) << e;
+}
+
+static size_t lut_index(int64_t t, bool log_spacing, unsigned int shift, unsigned int *step) {
+    if (!log_spacing) {
+        *step = shift;
+        return t >> shift;
+    }
+    int msb = t > 0 ? 63 - __builtin_clzll(t) : 0;
+    *step = msb > (int)shift ? msb - shift : 0;
+    return ((size_t)*step << shift) + (t >> *step);
+}
+
+static void build_lut(struct curve *c, enum engine engine, size_t num_points, bool log_spacing,
+                      unsigned int shift) {
+    int32_t last_time = c->points[(num_points - 1) * 2];
+    unsigned int step;
+
+    // Coarsen the table until it fits
+    while (lut_index(last_time, log_spacing, shift, &step) + 2 > MAX_LUT_LEN) {
+        shift++;
+    }
+
+    struct zip_speed_curve_profile *p = &c->profiles[engine];
+    p->lut = c->lut[engine];
+    p->lut_len = lut_index(last_time, log_spacing, shift, &step) + 2;
+    p->lut_shift = shift;
+    p->lut_log = log_spacing;
+    for (size_t i = 0; i < p->lut_len; i++) {
+        c->lut[engine][i] =
+            zip_speed_curve_eval_reference(&c->profiles[ENGINE_SEARCH], lut_time(i, log_spacing,
+                                                                                 shift));
+    }
+}
+
+static size_t random_curve(struct curve *c, uint8_t interpolation) {
+    size_t num_points = rnd_range(2, MAX_POINTS);
+    int32_t t = rnd() % 4 == 0 ? rnd_range(1, 200) : 0;
+
+    memset(c, 0, sizeof(*c));
+    for (size_t i = 0; i < num_points; i++) {
+        // Half of the speeds are round numbers, which give whole pixels per frame
+        int32_t speed = rnd() % 2 ? rnd_range(0, 20000) : rnd_range(0, 160) * 125;
+
+        c->points[i * 2] = t;
+        c->points[i * 2 + 1] = speed;
+        t += rnd() % 3 == 0 ? rnd_range(1, 20) : rnd_range(20, 3000);
+    }
+
+    for (size_t i = 0; i + 1 < num_points; i++) {
+        int64_t ds = c->points[(i + 1) * 2 + 1] - c->points[i * 2 + 1];
+        int64_t dt = c->points[(i + 1) * 2] - c->points[i * 2];
+        c->slopes[i] = ds * (1 << ZIP_SPEED_CURVE_FRAC_BITS) / dt;
+    }
+
+    for (int e = 0; e < ENGINE_COUNT; e++) {
+        c->profiles[e] = (struct zip_speed_curve_profile){
+            .curve_points = c->points,
+            .curve_points_len = num_points * 2,
+            .slopes = e == ENGINE_SEARCH ? NULL : c->slopes,
+            .interpolation = interpolation,
+        };
+    }
+    build_lut(c, ENGINE_LUT, num_points, false, rnd_range(0, 6));
+    build_lut(c, ENGINE_LUT_LOG, num_points, true, rnd_range(1, 5));
+
+    return num_points;
+}
+
+/*
+ * Speed check
+ */
+
+/**
+ * @brief Largest difference between a table lookup and the original curve
+ *
+ * Computed from the table entries over the table's own cells, as
+ * scripts/speed_curve_blob.py does for --max-error, so it bounds what the
+ * engine may give wherever it uses the table.
+ */
+static int32_t lut_error(const struct curve *c, const struct zip_speed_curve_profile *p,
+                         size_t num_points) {
+    int32_t error = 0;
+
+    for (int64_t t = c->points[0] + 1; t < c->points[(num_points - 1) * 2]; t++) {
+        unsigned int step;
+        size_t index = lut_index(t, p->lut_log, p->lut_shift, &step);
+
+        if (index + 1 >= p->lut_len) {
+            break;
+        }
+        int64_t s0 = p->lut[index];
+        int64_t s1 = p->lut[index + 1];
+        int64_t value = s0 + (((s1 - s0) * (t & ((INT64_C(1) << step) - 1))) >> step);
+        error = MAX(error, llabs(value - original_speed(c->points, num_points, false, t)));
+    }
+    return error;
+}
+
+static bool check_speeds(const struct curve *c, size_t num_points, bool step) {
+    int32_t last_time = c->points[(num_points - 1) * 2];
+    int32_t table_error[ENGINE_COUNT] = {0};
+    bool ok = true;
+
+    for (int e = 0; e < ENGINE_COUNT; e++) {
+        if (!zip_speed_curve_profile_valid(&c->profiles[e])) {
+            printf("%s: generated profile rejected\n", engine_names[e]);
+            stats[e].violations++;
+            ok = false;
+        }
+        if (!step && c->profiles[e].lut != NULL) {
+            table_error[e] = lut_error(c, &c->profiles[e], num_points);
+        }
+    }
+
+    for (int64_t t = 0; t <= last_time + 2; t++) {
+        int32_t expected = original_speed(c->points, num_points, step, t);
+
+        for (int e = 0; e < ENGINE_COUNT; e++) {
+            const struct zip_speed_curve_profile *p = &c->profiles[e];
+            int32_t speed = zip_speed_curve_eval(p, t);
+            int32_t error = abs(speed - expected);
+            int32_t budget = 0;
+
+            if (!step && e == ENGINE_SLOPES) {
+                budget = SLOPE_SPEED_BUDGET;
+            } else if (!step && p->lut != NULL) {
+                unsigned int shift;
+                size_t index = lut_index(t, p->lut_log, p->lut_shift, &shift);
+                int64_t t0 = lut_time(index, p->lut_log, p->lut_shift);
+                int64_t t1 = t0 + (INT64_C(1) << shift);
+
+                // Past the table the slopes take over
+                budget = index + 1 < p->lut_len ? MIN(LUT_SPEED_BUDGET, table_error[e])
+                                                : SLOPE_SPEED_BUDGET;
+                for (size_t i = 0; index + 1 < p->lut_len && i < num_points; i++) {
+                    if (c->points[i * 2] > t0 && c->points[i * 2] < t1) {
+                        // A breakpoint inside the cell: the table cuts the corner
+                        budget = table_error[e];
+                    }
+                }
+            }
+
+            stats[e].max_speed_error = MAX(stats[e].max_speed_error, error);
+            stats[e].max_speed_budget = MAX(stats[e].max_speed_budget, budget);
+            if (error > budget) {
+                if (stats[e].violations++ == 0) {
+                    printf("%s: speed %" PRId32 " px/s at %" PRId64 " ms, original %" PRId32
+                           " px/s, budget %" PRId32 " px/s\n",
+                           engine_names[e], speed, t, expected, budget);
+                }
+                ok = false;
+            }
+        }
+    }
+
+    return ok;
+}
+
+/*
+ * Event path check
+ */
+
+struct scenario {
+    uint16_t period;
+    uint32_t multiplier;
+    uint32_t divisor;
+    bool track_remainders;
+    bool step;
+    size_t num_points;
+    size_t num_codes;
+};
+
+struct engine_run {
+    struct host_speed_curve inst;
+    struct exact_axis exact[2];
+};
+
+static struct engine_run runs[ENGINE_COUNT];
+
+static void start_movement(struct exact_axis *x) { memset(x, 0, sizeof(*x)); }
+
+/**
+ * @brief Hold an engine's pixels against the exact movement
+ *
+ * @return false on a budget violation
+ */
+static bool check_exact(const struct scenario *sc, struct exact_axis *x, int32_t speed,
+                        int64_t pixels) {
+    int64_t num = (int64_t)speed * sc->period * sc->multiplier;
+    int64_t den = 1000LL * sc->divisor;
+
+    if (!sc->track_remainders) {
+        // Whole pixels of this frame; the rounded-up scale may reach the next
+        // pixel from just below it, but never lose one
+        int64_t expected = num / den;
+        int64_t below = den - num % den;
+        bool may_round_up = num % den != 0 && (below << 32) <= (int64_t)(speed + 1) * den;
+
+        return pixels == expected || (may_round_up && pixels == expected + 1);
+    }
+
+    // With remainders the pixels so far must follow the exact running sum; each
+    // frame may lose up to 2^-16 px to truncation unless it is a multiple of 2^-16
+    x->num += num;
+    x->inexact += (num << ZIP_SPEED_CURVE_FRAC_BITS) % den != 0;
+    x->speeds += speed + 1;
+    x->emitted += pixels;
+
+    int64_t expected = x->num / den;
+    int64_t frac = x->num % den;
+    bool may_lose = (frac << ZIP_SPEED_CURVE_FRAC_BITS) < x->inexact * den;
+    bool may_gain = ((den - frac) << 32) <= x->speeds * den;
+
+    return x->emitted == expected || (may_lose && x->emitted == expected - 1) ||
+           (may_gain && x->emitted == expected + 1);
+}
+
+static bool run_scenario(const struct curve *c, const struct scenario *sc) {
+    struct original_axis orig[2] = {0};
+    bool ok = true;
+
+    for (int e = 0; e < ENGINE_COUNT; e++) {
+        host_speed_curve_setup(&runs[e].inst, &c->profiles[e], sc->num_codes, sc->period,
+                               sc->multiplier, sc->divisor);
+        runs[e].inst.cfg.track_remainders = sc->track_remainders;
+        host_speed_curve_init(&runs[e].inst);
+        start_movement(&runs[e].exact[0]);
+        start_movement(&runs[e].exact[1]);
+    }
+
+    host_uptime_ms = rnd_range(1, 100000);
+    host_cycles = rnd();
+
+    int movements = rnd_range(1, 12);
+    for (int m = 0; m < movements; m++) {
+        int frames = rnd() % 4 == 0 ? rnd_range(1, 10) : rnd_range(10, 600);
+        int code = rnd() % sc->num_codes;
+        int8_t direction = rnd() % 2 ? 1 : -1;
+        int reverse_at = rnd() % 4 == 0 ? rnd_range(0, frames) : -1;
+        int jitter = rnd() % 2 ? rnd_range(0, 3) : 0;
+        bool zero_end = rnd() % 2;
+
+        for (int f = 0; f <= frames; f++) {
+            bool stop = f == frames;
+            if (stop && !zero_end) {
+                break;
+            }
+            if (f == reverse_at) {
+                direction = -direction;
+            }
+
+            struct original_axis *o = &orig[code];
+            int32_t value = stop ? 0 : direction;
+            int64_t now = host_uptime_ms;
+            int32_t original = 0;
+            int64_t elapsed = 0;
+            bool restart = false;
+
+            // Original handle_event(), float math and all
+            if (o->last_event_time != 0 && now - o->last_event_time > ZIP_SPEED_CURVE_TIMEOUT_MS) {
+                o->start_time = 0;
+                o->remainder = 0.0f;
+                restart = true;
+            }
+            o->last_event_time = now;
+            if (value == 0) {
+                o->last_direction = 0;
+                o->start_time = 0;
+                o->last_event_time = 0;
+                o->remainder = 0.0f;
+                restart = true;
+            } else {
+                if (o->last_direction != 0 && o->last_direction != direction) {
+                    o->start_time = 0;
+                    o->remainder = 0.0f;
+                    restart = true;
+                }
+                o->last_direction = direction;
+                if (o->start_time == 0) {
+                    o->start_time = now;
+                    restart = true;
+                }
+                elapsed = now - o->start_time;
+
+                float movement =
+                    (float)original_speed(c->points, sc->num_points, sc->step, elapsed) *
+                    sc->period / 1000.0f * sc->multiplier / sc->divisor;
+                if (sc->track_remainders) {
+                    original_track_remainder(&movement, &o->remainder);
+                }
+                original = direction * (int32_t)movement;
+            }
+
+            for (int e = 0; e < ENGINE_COUNT; e++) {
+                struct engine_stats *st = &stats[e];
+                struct exact_axis *x = &runs[e].exact[code];
+                struct input_event event = {
+                    .sync = true,
+                    .type = INPUT_EV_REL,
+                    .code = INPUT_REL_X + code,
+                    .value = value,
+                };
+
+                if (restart) {
+                    start_movement(x);
+                }
+                host_speed_curve_event(&runs[e].inst, &event, 0, 0);
+
+                int32_t deviation = abs(event.value - original);
+                x->original += direction * original;
+                st->frames++;
+
+                bool exact_ok = true;
+                if (value != 0) {
+                    int32_t speed = zip_speed_curve_eval(&c->profiles[e], elapsed);
+                    x->diverged |=
+                        speed != original_speed(c->points, sc->num_points, sc->step, elapsed);
+                    exact_ok = event.value * direction >= 0 &&
+                               check_exact(sc, x, speed, abs(event.value));
+                    if (!x->diverged) {
+                        int64_t drift = llabs(x->emitted - x->original);
+                        st->max_frame_deviation = MAX(st->max_frame_deviation, deviation);
+                        exact_ok &= deviation <= FRAME_BUDGET;
+                        if (sc->track_remainders) {
+                            st->max_drift = MAX(st->max_drift, drift);
+                            exact_ok &= drift <= DRIFT_BUDGET;
+                        }
+                    }
+                    st->exact_mismatches += event.value != original;
+                } else {
+                    exact_ok = event.value == 0;
+                }
+
+                if (!exact_ok) {
+                    if (st->violations++ == 0) {
+                        printf("%s: frame %d of movement %d at %" PRId64 " ms: %" PRId32
+                               " px, original %" PRId32 " px (period %u ms, scale %u/%u, "
+                               "remainders %s)\n",
+                               engine_names[e], f, m, elapsed, event.value, original,
+                               sc->period, sc->multiplier, sc->divisor,
+                               sc->track_remainders ? "on" : "off");
+                    }
+                    ok = false;
+                }
+            }
+
+            host_uptime_ms += sc->period + rnd_range(-jitter, jitter);
+            host_cycles += rnd();
+        }
+
+        // Pause: sometimes short enough to continue, mostly past the timeout
+        host_uptime_ms += rnd() % 4 == 0 ? rnd_range(1, ZIP_SPEED_CURVE_TIMEOUT_MS)
+                                         : rnd_range(ZIP_SPEED_CURVE_TIMEOUT_MS + 1, 5000);
+    }
+
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    uint64_t seed = argc > 1 ? strtoull(argv[1], NULL, 0) : 1;
+    long scenarios = argc > 2 ? strtol(argv[2], NULL, 0) : 2000;
+    static struct curve c;
+    long failed = 0;
+
+    rng_state = seed != 0 ? seed : 1;
+
+    // The build-time bound has to agree with the search it stands for
+    for (size_t n = 2; n <= 1025; n++) {
+        if (ZIP_SPEED_CURVE_SEARCH_DEPTH(n) != zip_speed_curve_search_depth(n)) {
+            printf("ZIP_SPEED_CURVE_SEARCH_DEPTH(%zu) != zip_speed_curve_search_depth()\n", n);
+            failed++;
+        }
+    }
+
+    for (long i = 0; i < scenarios; i++) {
+        bool step = rnd() % 8 == 0;
+        struct scenario sc = {
+            .period = rnd() % 2 ? 16 : rnd_range(1, 50),
+            .multiplier = rnd() % 2 ? 1 : rnd_range(1, 8),
+            .divisor = rnd() % 2 ? 1 : rnd_range(1, 8),
+            .track_remainders = rnd() % 2,
+            .step = step,
+            .num_codes = rnd_range(1, 2),
+        };
+
+        sc.num_points =
+            random_curve(&c, step ? ZIP_SPEED_CURVE_INTERP_STEP : ZIP_SPEED_CURVE_INTERP_LINEAR);
+        if (!check_speeds(&c, sc.num_points, step) || !run_scenario(&c, &sc)) {
+            failed++;
+        }
+    }
+
+    printf("%-8s %10s %12s %12s %12s %10s %12s %10s\n", "engine", "frames", "speed err",
+           "err budget", "frame dev", "drift", "mismatches", "failures");
+    for (int e = 0; e < ENGINE_COUNT; e++) {
+        printf("%-8s %10" PRId64 " %9" PRId32 " px/s %7" PRId32 " px/s %9" PRId32 " px %7" PRId64
+               " px %12" PRId64 " %10" PRId64 "\n",
+               engine_names[e], stats[e].frames, stats[e].max_speed_error,
+               stats[e].max_speed_budget,
+               stats[e].max_frame_deviation, stats[e].max_drift, stats[e].exact_mismatches,
+               stats[e].violations);
+    }
+    printf("seed %" PRIu64 ", %ld scenarios, %ld failed\n", seed, scenarios, failed);
+
+    return failed != 0;
+}
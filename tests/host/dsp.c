@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Bit-exact test of the DSP engine (src/speed_curve_engine_dsp.c) against the
+ * portable C path, with the DSP intrinsics emulated by stubs/cmsis_core.h.
+ * tests/engine_dsp runs the same comparison on an emulated Cortex-M4.
+ *
+ * Usage: dsp [seed] [pairs]
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <zephyr/sys/util.h>
+#include <zmk/input_processors/speed_curve_engine.h>
+
+#ifndef CONFIG_ZMK_INPUT_PROCESSOR_SPEED_CURVE_DSP
+#error "build with -DCONFIG_ZMK_INPUT_PROCESSOR_SPEED_CURVE_DSP=1"
+#endif
+
+// Values around the 16-bit lanes' limits and the int32 extremes
+static const int32_t edges[] = {
+    0, 1, -1, 127, -128, 255, -255, INT16_MAX, INT16_MIN, -INT16_MAX, INT16_MAX + 1,
+    INT16_MIN - 1, 65535, -65536, INT32_MAX, -INT32_MAX,
+};
+
+static uint64_t rng_state;
+
+static uint32_t rng(void) {
+    // xorshift64*
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return (rng_state * 0x2545F4914F6CDD1DULL) >> 32;
+}
+
+// Mostly values that fit the 16-bit lanes, sometimes any int32 above INT32_MIN
+static int32_t random_value(void) {
+    switch (rng() % 4) {
+    case 0:
+        return (int32_t)(rng() % 255) - 127;
+    case 1:
+    case 2:
+        return (int16_t)rng();
+    default:
+        return MAX((int32_t)rng(), -INT32_MAX);
+    }
+}
+
+static int failures;
+
+static void check(int32_t x, int32_t y) {
+    uint64_t dsp = zip_speed_curve_norm_sq2(x, y);
+    uint64_t portable = zip_speed_curve_norm_sq2_portable(x, y);
+
+    if (dsp != portable) {
+        if (failures++ < 10) {
+            printf("FAIL norm_sq2(%" PRId32 ", %" PRId32 "): dsp %" PRIu64 ", portable %" PRIu64
+                   "\n",
+                   x, y, dsp, portable);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    uint64_t seed = argc > 1 ? strtoull(argv[1], NULL, 0) : 1;
+    long pairs = argc > 2 ? strtol(argv[2], NULL, 0) : 1000000;
+    size_t num_edges = sizeof(edges) / sizeof(edges[0]);
+
+    rng_state = seed * 0x9E3779B97F4A7C15ULL + 1;
+
+    for (size_t i = 0; i < num_edges; i++) {
+        for (size_t j = 0; j < num_edges; j++) {
+            check(edges[i], edges[j]);
+        }
+    }
+    for (long i = 0; i < pairs; i++) {
+        check(random_value(), random_value());
+    }
+
+    printf("seed %" PRIu64 ", %ld pairs, %d failed\n", seed, pairs, failures);
+    return failures != 0;
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Stand-in for libFuzzer's driver, for compilers without -fsanitize=fuzzer.
+ *
+ * Runs the fuzz target on the files given as arguments (a corpus or crash
+ * reproducers), or without arguments on random inputs:
+ *
+ *   fuzz_smoke [file...]
+ *   FUZZ_SEED=7 FUZZ_RUNS=100000 fuzz_smoke
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define FUZZ_MAX_INPUT 4096
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+static uint8_t input[FUZZ_MAX_INPUT];
+
+static int run_file(const char *path) {
+    FILE *f = fopen(path, "rb");
+
+    if (f == NULL) {
+        perror(path);
+        return 1;
+    }
+    size_t size = fread(input, 1, sizeof(input), f);
+    fclose(f);
+
+    LLVMFuzzerTestOneInput(input, size);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1) {
+        for (int i = 1; i < argc; i++) {
+            if (run_file(argv[i]) != 0) {
+                return 1;
+            }
+        }
+        printf("%d inputs ok\n", argc - 1);
+        return 0;
+    }
+
+    const char *seed = getenv("FUZZ_SEED");
+    const char *runs_env = getenv("FUZZ_RUNS");
+    long runs = runs_env != NULL ? strtol(runs_env, NULL, 0) : 20000;
+    uint64_t state = seed != NULL ? strtoull(seed, NULL, 0) : 1;
+
+    for (long run = 0; run < runs; run++) {
+        // splitmix64; input sizes favour short inputs, where every field matters
+        size_t size = 0;
+        for (size_t i = 0; i < FUZZ_MAX_INPUT; i++) {
+            uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            z ^= z >> 31;
+            if (i == 0) {
+                size = z % (z & 1 ? 256 : FUZZ_MAX_INPUT);
+            }
+            if (i >= size) {
+                break;
+            }
+            input[i] = z >> 24;
+        }
+        LLVMFuzzerTestOneInput(input, size);
+    }
+    printf("%ld random inputs ok\n", runs);
+    return 0;
+}
@@ -0,0 +1,327 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * libFuzzer target for the curve engine, blob validation and event path.
+ *
+ * The input is read as a sequence of fields: a curve (valid or not, with or
+ * without slopes and a lookup table), a curve blob (raw bytes or a well-formed
+ * header around fuzzed contents, so the CRC does not stop the fuzzer), an
+ * instance configuration as devicetree could give it, and a stream of events
+ * with clock jumps, cycle counter wraparound and a possible zero start time.
+ * Fields past the end of the input read as zero.
+ *
+ * Built with sanitizers, any undefined behaviour or overflow aborts the run.
+ * On top of that the target checks that evaluated speeds stay within
+ * 0..ZIP_SPEED_CURVE_MAX_SPEED, that accepted blobs are valid profiles and
+ * that processed events never exceed max-output.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <zephyr/sys/crc.h>
+
+#include "speed_curve_host.h"
+
+#define FUZZ_MAX_POINTS CONFIG_ZMK_INPUT_PROCESSOR_SPEED_CURVE_MAX_POINTS
+#define FUZZ_MAX_LUT_LEN 512
+#define FUZZ_MAX_EVENTS 512
+
+struct fuzz_input {
+    const uint8_t *data;
+    size_t size;
+};
+
+static uint64_t take(struct fuzz_input *in, size_t bytes) {
+    uint64_t value = 0;
+
+    for (size_t i = 0; i < bytes && in->size > 0; i++) {
+        value |= (uint64_t)*in->data << (8 * i);
+        in->data++;
+        in->size--;
+    }
+    return value;
+}
+
+static void check(bool condition, const char *what) {
+    if (!condition) {
+        fprintf(stderr, "fuzz_speed_curve: %s\n", what);
+        abort();
+    }
+}
+
+struct fuzz_curve {
+    int32_t points[FUZZ_MAX_POINTS * 2];
+    int32_t slopes[FUZZ_MAX_POINTS];
+    int32_t lut[FUZZ_MAX_LUT_LEN];
+    struct zip_speed_curve_profile profile;
+};
+
+static void take_curve(struct fuzz_input *in, struct fuzz_curve *c) {
+    uint8_t flags = take(in, 1);
+    size_t num_points = 2 + take(in, 1) % (FUZZ_MAX_POINTS - 1);
+    int64_t t = flags & 0x01 ? (int32_t)take(in, 4) : take(in, 2);
+
+    memset(c, 0, sizeof(*c));
+    for (size_t i = 0; i < num_points; i++) {
+        // Raw values exercise validation, derived ones the evaluation
+        c->points[i * 2] = flags & 0x01 ? (int32_t)take(in, 4) : (int32_t)MIN(t, INT32_MAX);
+        c->points[i * 2 + 1] = flags & 0x01 ? (int32_t)take(in, 4)
+                                            : take(in, 3) % (ZIP_SPEED_CURVE_MAX_SPEED + 1);
+        t += 1 + take(in, flags & 0x02 ? 4 : 2);
+    }
+
+    c->profile = (struct zip_speed_curve_profile){
+        .curve_points = c->points,
+        .curve_points_len = num_points * 2,
+        .interpolation = (flags >> 2) & 1,
+    };
+    if (!zip_speed_curve_profile_valid(&c->profile)) {
+        return;
+    }
+
+    if (flags & 0x08) {
+        for (size_t i = 0; i + 1 < num_points; i++) {
+            int64_t ds = c->points[(i + 1) * 2 + 1] - c->points[i * 2 + 1];
+            int64_t dt = c->points[(i + 1) * 2] - c->points[i * 2];
+            c->slopes[i] = ds * (1 << ZIP_SPEED_CURVE_FRAC_BITS) / dt;
+        }
+        c->profile.slopes = c->slopes;
+    }
+
+    if (flags & 0x10) {
+        // Table entries need not match the curve, only be valid speeds
+        c->profile.lut = c->lut;
+        c->profile.lut_len = take(in, 2) % (FUZZ_MAX_LUT_LEN + 1);
+        c->profile.lut_shift = take(in, 1) % ZIP_SPEED_CURVE_FRAC_BITS;
+        c->profile.lut_log = flags & 0x20;
+        for (size_t i = 0; i < c->profile.lut_len; i++) {
+            c->lut[i] = take(in, 3) % (ZIP_SPEED_CURVE_MAX_SPEED + 1);
+        }
+    }
+}
+
+static void check_eval(const struct zip_speed_curve_profile *profile, int64_t position) {
+    int32_t speed = zip_speed_curve_eval(profile, position);
+    int32_t reference = zip_speed_curve_eval_reference(profile, position);
+
+    check(speed >= 0 && speed <= ZIP_SPEED_CURVE_MAX_SPEED, "speed out of range");
+    check(reference >= 0 && reference <= ZIP_SPEED_CURVE_MAX_SPEED, "reference out of range");
+}
+
+// Blob storage, word-aligned as a flash partition is
+static uint32_t blob_words[(sizeof(struct zip_speed_curve_blob_header) +
+                            (FUZZ_MAX_POINTS * 3 + FUZZ_MAX_LUT_LEN) * sizeof(int32_t)) /
+                           sizeof(uint32_t)];
+
+static size_t take_blob(struct fuzz_input *in, const struct fuzz_curve *c) {
+    uint8_t *blob = (uint8_t *)blob_words;
+    struct zip_speed_curve_blob_header *hdr = (struct zip_speed_curve_blob_header *)blob;
+    uint8_t mode = take(in, 1) % 4;
+
+    if (mode == 0) {
+        return 0;
+    }
+
+    if (mode == 1) {
+        // Raw bytes
+        size_t size = take(in, 2) % (sizeof(blob_words) + 1);
+        for (size_t i = 0; i < size; i++) {
+            blob[i] = take(in, 1);
+        }
+        return size;
+    }
+
+    // Header around the fuzzed curve; mode 3 also corrupts a header field
+    size_t num_points = c->profile.curve_points_len / 2;
+    size_t lut_len = mode == 3 ? take(in, 2) % (FUZZ_MAX_LUT_LEN + 1) : c->profile.lut_len;
+    int32_t *payload = (int32_t *)(hdr + 1);
+    size_t words = 0;
+
+    for (size_t i = 0; i < num_points * 2; i++) {
+        payload[words++] = c->points[i];
+    }
+    for (size_t i = 0; i + 1 < num_points; i++) {
+        payload[words++] = c->profile.slopes != NULL ? c->slopes[i] : (int32_t)take(in, 4);
+    }
+    for (size_t i = 0; i < lut_len; i++) {
+        payload[words++] = c->lut[i];
+    }
+
+    *hdr = (struct zip_speed_curve_blob_header){
+        .magic = ZIP_SPEED_CURVE_BLOB_MAGIC,
+        .version = ZIP_SPEED_CURVE_BLOB_VERSION,
+        .interpolation = c->profile.interpolation,
+        .lut_shift =
+            c->profile.lut_shift | (c->profile.lut_log ? ZIP_SPEED_CURVE_BLOB_LUT_LOG : 0),
+        .num_points = num_points,
+        .lut_len = lut_len,
+        .payload_len = words * sizeof(int32_t),
+    };
+    hdr->crc = crc32_ieee((const uint8_t *)payload, hdr->payload_len);
+    if (mode == 3) {
+        // The CRC only covers the payload, so this reaches the header checks
+        size_t offset = take(in, 1) % sizeof(*hdr);
+        ((uint8_t *)hdr)[offset] = take(in, 1);
+    }
+
+    return sizeof(*hdr) + words * sizeof(int32_t);
+}
+
+static struct host_speed_curve inst;
+static struct zip_speed_curve_profile profiles[2];
+
+static void take_config(struct fuzz_input *in, const struct fuzz_curve *c, size_t blob_size) {
+    size_t num_codes = 1 + take(in, 1) % HOST_SPEED_CURVE_MAX_CODES;
+    uint16_t period = 1 + take(in, 2) % UINT16_MAX;
+    uint32_t divisor = 1 + take(in, 2) % UINT16_MAX;
+    // Devicetree limits: period * multiplier below 2^31, gain below 2^32 in 16.16
+    uint64_t max_multiplier = MIN(INT32_MAX / period, ((uint64_t)divisor << 16) - 1);
+    uint32_t multiplier = 1 + take(in, 4) % max_multiplier;
+    uint8_t flags = take(in, 1);
+
+    host_speed_curve_setup(&inst, &c->profile, num_codes, period, multiplier, divisor);
+
+    struct zip_speed_curve_config *cfg = &inst.cfg;
+    cfg->type = flags & 0x01 ? INPUT_EV_ABS : INPUT_EV_REL;
+    cfg->track_remainders = flags & 0x02;
+    cfg->coalesce_reports = flags & 0x04;
+    cfg->suppress_zero_events = (flags & 0x08) || cfg->coalesce_reports;
+    cfg->curve_input = take(in, 1) % (ZIP_SPEED_CURVE_INPUT_DISTANCE_VECTOR + 1);
+    cfg->distance_reset_ms = take(in, 2);
+    cfg->resume_window_ms = take(in, 2);
+    cfg->resume_retain_percent = take(in, 1);
+    cfg->reversal_frames = take(in, 1);
+    cfg->reversal_threshold = take(in, 2);
+    cfg->velocity_filter = take(in, 1) % (ZIP_SPEED_CURVE_FILTER_ONE_EURO + 1);
+    cfg->filter_min_cutoff_mhz = take(in, 4);
+    cfg->filter_d_cutoff_mhz = take(in, 4);
+    cfg->filter_beta = take(in, 4);
+    cfg->prediction_ms = take(in, 2);
+    cfg->max_output = flags & 0x10 ? 1 + take(in, flags & 0x40 ? 4 : 1) % INT32_MAX
+                                   : CONFIG_ZMK_INPUT_PROCESSOR_SPEED_CURVE_MAX_OUTPUT;
+
+    // A second curve for param2 to select: the same points without tables
+    profiles[0] = c->profile;
+    profiles[1] = (struct zip_speed_curve_profile){
+        .curve_points = c->profile.curve_points,
+        .curve_points_len = c->profile.curve_points_len,
+        .interpolation = c->profile.interpolation,
+    };
+    cfg->profiles = profiles;
+    cfg->profiles_len = flags & 0x80 ? 2 : 1;
+
+    if (flags & 0x20) {
+        for (size_t i = 0; i < num_codes; i++) {
+            inst.axis_groups[i] = take(in, 1) % num_codes;
+        }
+        cfg->axis_groups = inst.axis_groups;
+    }
+    if (blob_size > 0) {
+        cfg->blob = blob_words;
+        cfg->blob_size = blob_size;
+    }
+}
+
+static void run_events(struct fuzz_input *in) {
+    const struct zip_speed_curve_config *cfg = &inst.cfg;
+
+    // Start at zero, just after boot, or anywhere; cycles may be about to wrap
+    switch (take(in, 1) % 3) {
+    case 0:
+        host_uptime_ms = 0;
+        break;
+    case 1:
+        host_uptime_ms = take(in, 1);
+        break;
+    default:
+        host_uptime_ms = take(in, 6);
+        break;
+    }
+    host_cycles = take(in, 4);
+
+    for (int n = 0; n < FUZZ_MAX_EVENTS && in->size > 0; n++) {
+        uint8_t op = take(in, 1);
+
+        // Clock: small steps, long pauses, or a cycle counter jump (wraparound)
+        uint64_t step = take(in, (op & 0x03) == 3 ? 4 : (op & 0x03));
+        host_uptime_ms += step;
+        host_cycles += (op & 0x04) ? (uint32_t)take(in, 4)
+                                   : (uint32_t)(step * HOST_CYCLES_PER_SEC / 1000);
+
+        if ((op & 0x18) == 0x18) {
+            zip_speed_curve_reset(&inst.dev);
+            continue;
+        }
+
+        struct input_event event = {
+            .sync = op & 0x20,
+            .type = cfg->type,
+            .code = cfg->codes[take(in, 1) % cfg->codes_len],
+        };
+        switch ((op >> 6) & 0x03) {
+        case 0:
+            event.value = (int8_t)take(in, 1);
+            break;
+        case 1:
+            event.value = (int32_t)take(in, 4);
+            break;
+        case 2:
+            // Touch-down/lift, or an unrelated event
+            event.type = INPUT_EV_KEY;
+            event.code = take(in, 1) & 1 ? INPUT_BTN_TOUCH : 0;
+            event.value = take(in, 1) & 1;
+            break;
+        default:
+            event.value = 0;
+            break;
+        }
+
+        uint32_t gain = take(in, 1) & 1 ? (uint32_t)take(in, 4) : 0;
+        uint32_t profile = take(in, 1);
+        bool processed = event.type == cfg->type;
+        int ret = host_speed_curve_event(&inst, &event, gain, profile);
+
+        check(ret == 0 || ret == ZMK_INPUT_PROC_STOP, "unexpected return value");
+        if (processed && ret == 0) {
+            check(event.value >= -cfg->max_output && event.value <= cfg->max_output,
+                  "event exceeds max-output");
+        }
+    }
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    struct fuzz_input in = {.data = data, .size = size};
+    static struct fuzz_curve c;
+
+    take_curve(&in, &c);
+    bool valid = zip_speed_curve_profile_valid(&c.profile);
+
+    for (int i = 0; valid && i < 4; i++) {
+        check_eval(&c.profile, (int64_t)take(&in, 8));
+    }
+
+    size_t blob_size = take_blob(&in, &c);
+    struct zip_speed_curve_profile blob_profile;
+    if (blob_size > 0 && host_speed_curve_load_blob(blob_words, blob_size, &blob_profile) == 0) {
+        check(zip_speed_curve_profile_valid(&blob_profile), "accepted blob is not a valid profile");
+        check_eval(&blob_profile, (int64_t)take(&in, 8));
+    }
+
+    if (!valid) {
+        return 0;
+    }
+
+    take_config(&in, &c, blob_size);
+    if (host_speed_curve_init(&inst) != 0) {
+        return 0;
+    }
+    run_events(&in);
+
+    return 0;
+}
@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Replay a recorded event stream through the processor.
+ *
+ * Reads events in the format of scripts/speed_curve_trace.py, one
+ * "time_ms type code value sync" per line, sets the host clock to each
+ * event's time and passes it to the processor. The events the processor
+ * forwards are printed in the same format, so the output can be replayed
+ * again or compared against an earlier run. Blank lines and lines starting
+ * with '#' are skipped. The totals per code go to stderr.
+ *
+ * Usage: replay [options] [events.txt]
+ *   --points "t s t s ..."  curve points (default "0 50 300 200 1000 800")
+ *   --input NAME            curve-input: time, frames, velocity, distance, distance-vector
+ *   --period MS             trigger-period-ms (default 16)
+ *   --scale MUL/DIV         scale-multiplier and scale-divisor (default 1/1)
+ *   --codes N               codes INPUT_REL_X onwards (default 2)
+ *   --abs                   type INPUT_EV_ABS instead of INPUT_EV_REL
+ *   --remainders            track-remainders
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "speed_curve_host.h"
+
+static const char *const input_names[] = {
+    [ZIP_SPEED_CURVE_INPUT_TIME] = "time",
+    [ZIP_SPEED_CURVE_INPUT_FRAMES] = "frames",
+    [ZIP_SPEED_CURVE_INPUT_VELOCITY] = "velocity",
+    [ZIP_SPEED_CURVE_INPUT_DISTANCE] = "distance",
+    [ZIP_SPEED_CURVE_INPUT_DISTANCE_VECTOR] = "distance-vector",
+};
+
+static int32_t points[CONFIG_ZMK_INPUT_PROCESSOR_SPEED_CURVE_MAX_POINTS * 2];
+static struct host_speed_curve inst;
+
+static size_t parse_points(const char *text) {
+    size_t len = 0;
+    char *end;
+
+    // Accepts devicetree syntax too: <0 50>, <300 200>
+    for (;;) {
+        text += strspn(text, " ,<>");
+        long value = strtol(text, &end, 0);
+        if (end == text) {
+            break;
+        }
+        if (len == ARRAY_SIZE(points)) {
+            return 0;
+        }
+        points[len++] = value;
+        text = end;
+    }
+    return len % 2 == 0 ? len : 0;
+}
+
+static int usage(const char *message) {
+    fprintf(stderr, "replay: %s\n", message);
+    fprintf(stderr, "usage: replay [--points \"t s ...\"] [--input NAME] [--period MS] "
+                    "[--scale MUL/DIV] [--codes N] [--abs] [--remainders] [events.txt]\n");
+    return 2;
+}
+
+int main(int argc, char **argv) {
+    const char *points_text = "0 50 300 200 1000 800";
+    const char *path = NULL;
+    uint8_t curve_input = ZIP_SPEED_CURVE_INPUT_TIME;
+    unsigned long period = 16;
+    unsigned long multiplier = 1;
+    unsigned long divisor = 1;
+    unsigned long num_codes = 2;
+    bool abs_input = false;
+    bool remainders = false;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if (strcmp(arg, "--abs") == 0) {
+            abs_input = true;
+            continue;
+        }
+        if (strcmp(arg, "--remainders") == 0) {
+            remainders = true;
+            continue;
+        }
+        if (strncmp(arg, "--", 2) != 0) {
+            path = arg;
+            continue;
+        }
+        if (value == NULL) {
+            return usage("missing option value");
+        }
+        i++;
+        if (strcmp(arg, "--points") == 0) {
+            points_text = value;
+        } else if (strcmp(arg, "--period") == 0) {
+            period = strtoul(value, NULL, 0);
+        } else if (strcmp(arg, "--codes") == 0) {
+            num_codes = strtoul(value, NULL, 0);
+        } else if (strcmp(arg, "--scale") == 0) {
+            if (sscanf(value, "%lu/%lu", &multiplier, &divisor) != 2) {
+                return usage("--scale takes MUL/DIV");
+            }
+        } else if (strcmp(arg, "--input") == 0) {
+            curve_input = ARRAY_SIZE(input_names);
+            for (size_t n = 0; n < ARRAY_SIZE(input_names); n++) {
+                if (strcmp(value, input_names[n]) == 0) {
+                    curve_input = n;
+                }
+            }
+            if (curve_input == ARRAY_SIZE(input_names)) {
+                return usage("unknown curve input");
+            }
+        } else {
+            return usage("unknown option");
+        }
+    }
+
+    size_t points_len = parse_points(points_text);
+    if (points_len < 4) {
+        return usage("--points needs 2 to CONFIG_ZMK_INPUT_PROCESSOR_SPEED_CURVE_MAX_POINTS "
+                     "[time_ms speed] pairs");
+    }
+    if (period == 0 || period > UINT16_MAX || divisor == 0 || num_codes == 0 ||
+        num_codes > HOST_SPEED_CURVE_MAX_CODES) {
+        return usage("option out of range");
+    }
+
+    struct zip_speed_curve_profile profile = {
+        .curve_points = points,
+        .curve_points_len = points_len,
+    };
+    host_speed_curve_setup(&inst, &profile, num_codes, period, multiplier, divisor);
+    inst.cfg.type = abs_input ? INPUT_EV_ABS : INPUT_EV_REL;
+    inst.cfg.curve_input = curve_input;
+    inst.cfg.track_remainders = remainders;
+    if (host_speed_curve_init(&inst) != 0) {
+        fprintf(stderr, "replay: invalid curve\n");
+        return 1;
+    }
+
+    FILE *f = path != NULL ? fopen(path, "r") : stdin;
+    if (f == NULL) {
+        perror(path);
+        return 1;
+    }
+
+    char line[256];
+    long line_no = 0;
+    long events = 0;
+    long forwarded = 0;
+    int64_t totals[HOST_SPEED_CURVE_MAX_CODES] = {0};
+
+    while (fgets(line, sizeof(line), f) != NULL) {
+        int64_t time_ms;
+        unsigned int type, code, sync;
+        int32_t value;
+        char *text = line + strspn(line, " \t");
+
+        line_no++;
+        if (*text == '#' || *text == '\n' || *text == '\0') {
+            continue;
+        }
+        if (sscanf(text, "%" SCNd64 " %u %u %" SCNd32 " %u", &time_ms, &type, &code, &value,
+                   &sync) != 5) {
+            fprintf(stderr, "replay: line %ld: expected \"time_ms type code value sync\"\n",
+                    line_no);
+            return 1;
+        }
+
+        // Both clocks follow the recorded time; the cycle counter wraps like the hardware one
+        host_uptime_ms = time_ms;
+        host_cycles = (uint64_t)time_ms * HOST_CYCLES_PER_SEC / 1000;
+
+        struct input_event event = {
+            .type = type,
+            .code = code,
+            .value = value,
+            .sync = sync != 0,
+        };
+        events++;
+        if (host_speed_curve_event(&inst, &event, 0, 0) != 0) {
+            continue;
+        }
+        forwarded++;
+        printf("%" PRId64 " %u %u %" PRId32 " %d\n", time_ms, event.type, event.code, event.value,
+               event.sync);
+        if (event.type == INPUT_EV_REL && event.code < INPUT_REL_X + num_codes) {
+            totals[event.code - INPUT_REL_X] += event.value;
+        }
+    }
+    if (f != stdin) {
+        fclose(f);
+    }
+
+    fprintf(stderr, "%ld events, %ld forwarded, totals", events, forwarded);
+    for (size_t i = 0; i < num_codes; i++) {
+        fprintf(stderr, " %" PRId64, totals[i]);
+    }
+    fprintf(stderr, "\n");
+    return 0;
+}
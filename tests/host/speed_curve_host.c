@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include "speed_curve_host.h"
+
+#include "../../src/speed_curve.c"
+
+int64_t host_uptime_ms;
+uint32_t host_cycles;
+
+void host_speed_curve_setup(struct host_speed_curve *inst,
+                            const struct zip_speed_curve_profile *profile, size_t num_codes,
+                            uint16_t trigger_period_ms, uint32_t scale_multiplier,
+                            uint32_t scale_divisor) {
+    memset(inst, 0, sizeof(*inst));
+
+    for (size_t i = 0; i < num_codes && i < HOST_SPEED_CURVE_MAX_CODES; i++) {
+        inst->codes[i] = INPUT_REL_X + i;
+    }
+
+    inst->cfg = (struct zip_speed_curve_config){
+        .type = INPUT_EV_REL,
+        .codes = inst->codes,
+        .codes_len = MIN(num_codes, HOST_SPEED_CURVE_MAX_CODES),
+        .profiles = profile,
+        .profiles_len = 1,
+        .trigger_period_ms = trigger_period_ms,
+        .movement_scale = ZIP_SPEED_CURVE_SCALE_32_32(
+            (uint64_t)trigger_period_ms * scale_multiplier, 1000ULL * scale_divisor),
+        .output_gain = ZIP_SPEED_CURVE_SCALE_16_16(scale_multiplier, scale_divisor),
+        .distance_reset_ms = 250,
+        .resume_retain_percent = 100,
+        .reversal_frames = 1,
+        .filter_min_cutoff_mhz = 1000,
+        .filter_d_cutoff_mhz = 1000,
+        .filter_beta = 7,
+        .max_output = CONFIG_ZMK_INPUT_PROCESSOR_SPEED_CURVE_MAX_OUTPUT,
+    };
+    inst->data.axes = inst->axes;
+    inst->data.groups = inst->groups;
+    inst->dev = (struct device){
+        .name = "host_speed_curve",
+        .config = &inst->cfg,
+        .data = &inst->data,
+        .api = &zip_speed_curve_driver_api,
+    };
+}
+
+int host_speed_curve_init(struct host_speed_curve *inst) {
+    const struct zip_speed_curve_config *cfg = &inst->cfg;
+
+    if (cfg->axis_groups != NULL) {
+        // Like ZIP_SPEED_CURVE_GROUP_NEXT(): the next code of the group, wrapping around
+        for (size_t i = 0; i < cfg->codes_len; i++) {
+            inst->group_next[i] = i;
+            for (size_t k = 1; k < cfg->codes_len; k++) {
+                size_t j = (i + k) % cfg->codes_len;
+                if (cfg->axis_groups[j] == cfg->axis_groups[i]) {
+                    inst->group_next[i] = j;
+                    break;
+                }
+            }
+        }
+        inst->cfg.group_next = inst->group_next;
+    }
+    return zip_speed_curve_init(&inst->dev);
+}
+
+int host_speed_curve_event(struct host_speed_curve *inst, struct input_event *event,
+                           uint32_t param1, uint32_t param2) {
+    const struct zmk_input_processor_driver_api *api = inst->dev.api;
+
+    return api->handle_event(&inst->dev, event, param1, param2, NULL);
+}
+
+int host_speed_curve_load_blob(const void *blob, size_t blob_size,
+                               struct zip_speed_curve_profile *profile) {
+    return load_curve_blob(blob, blob_size, profile);
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+/*
+ * Host build of the speed curve processor's event path.
+ *
+ * speed_curve_host.c compiles src/speed_curve.c against the stubs in
+ * stubs/, so tests can drive the real handle_event() with instances built
+ * at runtime instead of from devicetree, and a clock they control.
+ */
+
+// Kconfig of the host build
+#define CONFIG_ZMK_LOG_LEVEL 0
+#define CONFIG_ZMK_INPUT_PROCESSOR_SPEED_CURVE_MAX_OUTPUT 32767
+#define CONFIG_ZMK_INPUT_PROCESSOR_SPEED_CURVE_MAX_POINTS 32
+#define CONFIG_ZMK_INPUT_PROCESSOR_SPEED_CURVE_MAX_SEARCH_DEPTH 5
+#define CONFIG_ZMK_INPUT_PROCESSOR_SPEED_CURVE_BLOB 1
+#define CONFIG_ZMK_INPUT_PROCESSOR_SPEED_CURVE_FRAME_TIMEOUT 1
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/dt-bindings/input/input-event-codes.h>
+#include <drivers/input_processor.h>
+
+#include <zmk/input_processors/speed_curve.h>
+
+#define HOST_SPEED_CURVE_MAX_CODES 4
+
+/**
+ * @brief Processor instance with its state, as ZIP_SPEED_CURVE_DEFINE() would create it
+ */
+struct host_speed_curve {
+    struct device dev;
+    struct zip_speed_curve_config cfg;
+    struct zip_speed_curve_data data;
+    struct zip_speed_curve_axis axes[HOST_SPEED_CURVE_MAX_CODES];
+    struct zip_speed_curve_group groups[HOST_SPEED_CURVE_MAX_CODES];
+    uint16_t codes[HOST_SPEED_CURVE_MAX_CODES];
+    uint8_t axis_groups[HOST_SPEED_CURVE_MAX_CODES]; // Point cfg.axis_groups here to use them
+    uint8_t group_next[HOST_SPEED_CURVE_MAX_CODES];  // Filled in by host_speed_curve_init()
+};
+
+/**
+ * @brief Set up an instance with the devicetree defaults
+ *
+ * Codes are INPUT_REL_X, INPUT_REL_Y, ... Adjust inst->cfg afterwards for
+ * other properties, then call host_speed_curve_init().
+ *
+ * @param profile Main curve (profile 0)
+ * @param num_codes Number of codes, up to HOST_SPEED_CURVE_MAX_CODES
+ * @param trigger_period_ms trigger-period-ms
+ * @param scale_multiplier scale-multiplier
+ * @param scale_divisor scale-divisor
+ */
+void host_speed_curve_setup(struct host_speed_curve *inst,
+                            const struct zip_speed_curve_profile *profile, size_t num_codes,
+                            uint16_t trigger_period_ms, uint32_t scale_multiplier,
+                            uint32_t scale_divisor);
+
+/**
+ * @brief Run the processor's init function
+ *
+ * With cfg.axis_groups set, first builds the group rings the devicetree
+ * macro would generate.
+ */
+int host_speed_curve_init(struct host_speed_curve *inst);
+
+/**
+ * @brief Pass an event through the processor at the current host clock
+ *
+ * @return 0 if the event is forwarded, ZMK_INPUT_PROC_STOP if it is dropped
+ */
+int host_speed_curve_event(struct host_speed_curve *inst, struct input_event *event,
+                           uint32_t param1, uint32_t param2);
+
+/**
+ * @brief Validate a curve blob as the processor does at boot
+ *
+ * @return 0 and a profile pointing into the blob, or -EINVAL
+ */
+int host_speed_curve_load_blob(const void *blob, size_t blob_size,
+                               struct zip_speed_curve_profile *profile);
@@ -0,0 +1,26 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+/*
+ * The CMSIS DSP intrinsics src/speed_curve_engine_dsp.c uses, modelled after
+ * their pseudocode in the Armv7-M Architecture Reference Manual.
+ */
+
+#include <stdint.h>
+
+// Bottom halfword of op1, top halfword of op2 shifted left
+static inline uint32_t __PKHBT(uint32_t op1, uint32_t op2, uint32_t shift) {
+    return (op1 & 0x0000FFFF) | ((op2 << shift) & 0xFFFF0000);
+}
+
+// Sum of the products of the signed bottom and top halfwords, wrapping at 32 bits
+static inline uint32_t __SMUAD(uint32_t op1, uint32_t op2) {
+    int32_t bottom = (int32_t)(int16_t)op1 * (int16_t)op2;
+    int32_t top = (int32_t)(int16_t)(op1 >> 16) * (int16_t)(op2 >> 16);
+    return (uint32_t)bottom + (uint32_t)top;
+}
@@ -0,0 +1,29 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <zephyr/device.h>
+
+// Same layout as Zephyr's struct input_event
+struct input_event {
+    const struct device *dev;
+    uint8_t sync;
+    uint8_t type;
+    uint16_t code;
+    int32_t value;
+};
+
+struct zmk_input_processor_state;
+
+#define ZMK_INPUT_PROC_CONTINUE 0
+#define ZMK_INPUT_PROC_STOP 1
+
+struct zmk_input_processor_driver_api {
+    int (*handle_event)(const struct device *dev, struct input_event *event, uint32_t param1,
+                        uint32_t param2, struct zmk_input_processor_state *state);
+};
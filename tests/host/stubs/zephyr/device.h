@@ -0,0 +1,14 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+struct device {
+    const char *name;
+    const void *config;
+    void *data;
+    const void *api;
+};
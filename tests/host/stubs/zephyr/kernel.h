@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+/*
+ * Just enough of the Zephyr kernel API to build the processor on the host.
+ * The clock is driven by the test through host_uptime_ms and host_cycles.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <zephyr/sys/util.h>
+
+// Cycle counter rate of the host build, as on nRF52 (RTC-based)
+#define HOST_CYCLES_PER_SEC 32768
+
+extern int64_t host_uptime_ms;
+extern uint32_t host_cycles;
+
+static inline int64_t k_uptime_get(void) { return host_uptime_ms; }
+static inline uint32_t k_cycle_get_32(void) { return host_cycles; }
+
+static inline uint32_t k_ms_to_cyc_ceil32(uint32_t ms) {
+    return ((uint64_t)ms * HOST_CYCLES_PER_SEC + 999) / 1000;
+}
+
+static inline uint32_t k_cyc_to_ms_floor32(uint32_t cycles) {
+    return (uint64_t)cycles * 1000 / HOST_CYCLES_PER_SEC;
+}
+
+static inline uint32_t k_cyc_to_us_floor32(uint32_t cycles) {
+    return (uint64_t)cycles * 1000000 / HOST_CYCLES_PER_SEC;
+}
+
+struct k_spinlock {
+    int unused;
+};
+
+typedef int k_spinlock_key_t;
+
+static inline k_spinlock_key_t k_spin_lock(struct k_spinlock *lock) { return 0; }
+static inline void k_spin_unlock(struct k_spinlock *lock, k_spinlock_key_t key) {}
+
+// No devicetree on the host: tests build their instances at runtime
+#define DT_FOREACH_STATUS_OKAY(compat, fn)
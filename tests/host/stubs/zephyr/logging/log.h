@@ -0,0 +1,16 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+// Logging is compiled out; the arguments are still evaluated for their side effects
+static inline void host_log(const char *fmt, ...) { (void)fmt; }
+
+#define LOG_MODULE_DECLARE(...)
+#define LOG_DBG(...) host_log(__VA_ARGS__)
+#define LOG_INF(...) host_log(__VA_ARGS__)
+#define LOG_WRN(...) host_log(__VA_ARGS__)
+#define LOG_ERR(...) host_log(__VA_ARGS__)
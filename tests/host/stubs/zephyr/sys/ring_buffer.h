@@ -0,0 +1,15 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+// Only the type is needed; the host build has trace capture disabled
+struct ring_buf {
+    uint8_t *buffer;
+    uint32_t size;
+};
@@ -0,0 +1,25 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+/*
+ * The part of ZMK's drivers/input_processor.h the processor uses, so the
+ * Zephyr test suites build with plain Zephyr.
+ */
+
+#include <zephyr/device.h>
+#include <zephyr/input/input.h>
+
+struct zmk_input_processor_state;
+
+#define ZMK_INPUT_PROC_CONTINUE 0
+#define ZMK_INPUT_PROC_STOP 1
+
+struct zmk_input_processor_driver_api {
+    int (*handle_event)(const struct device *dev, struct input_event *event, uint32_t param1,
+                        uint32_t param2, struct zmk_input_processor_state *state);
+};